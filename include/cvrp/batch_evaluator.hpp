@@ -0,0 +1,133 @@
+/**
+ * @file batch_evaluator.hpp
+ * @author vss2sn
+ * @brief Contains the BatchEvaluator class that calculates the cost and
+ * validity of many chromosomes at once
+ */
+
+#ifndef BATCH_EVALUATOR_HPP
+#define BATCH_EVALUATOR_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include "cvrp/cost.hpp"
+#include "cvrp/utils.hpp"
+
+/**
+ * @brief struct Evaluation
+ * @details Cost of a chromosome, whether all of its routes are within the
+ * capacity of the vehicles, and the total load in excess of the capacity
+ */
+template <typename Cost>
+struct Evaluation {
+ public:
+  Cost cost_ = 0;
+  bool valid_ = true;
+  int excess_ = 0;
+};
+
+/**
+ * @brief class BatchEvaluator
+ * @details Holds a flat single precision copy of the distance matrix and the
+ * demands of the nodes. A chromosome is split into routes by its iterator
+ * vector: route k visits the nodes at positions [iterators[k],
+ * iterators[k + 1]). The cost and the loads are calculated in a single pass
+ * over the chromosome, accumulating distances as Cost (double, float or
+ * int32_t; integral costs use distances rounded to the nearest integer). When
+ * the processor supports AVX2 and the flat matrix can be indexed with 32 bit
+ * offsets (up to 46340 nodes), 8 chromosomes are evaluated at once with
+ * gathers from the flat matrix; results are identical to the portable
+ * implementation. Chromosomes can store their genes as uint16_t or int32_t.
+ */
+template <typename Gene, typename Cost>
+class BatchEvaluator {
+ public:
+  /**
+   * @brief Constructor
+   * @param nodes Vector of all nodes
+   * @param distanceMatrix Matrix containing distance between each pair of nodes
+   * @param capacity capacity of each vehicle
+   * @return no return value
+   */
+  BatchEvaluator(const std::vector<Node> &nodes,
+                 const std::vector<std::vector<double>> &distanceMatrix,
+                 const int capacity);
+
+  /**
+   * @brief Evaluates a single chromosome
+   * @param chromosome order in which the nodes are visited
+   * @param iterators points at which the chromosome is split into routes
+   * @return Evaluation cost and validity of the chromosome
+   */
+  Evaluation<Cost> Evaluate(const std::vector<Gene> &chromosome,
+                            const std::vector<Gene> &iterators) const;
+
+  /**
+   * @brief Evaluates a single chromosome and each of its routes
+   * @param chromosome order in which the nodes are visited
+   * @param iterators points at which the chromosome is split into routes
+   * @param route_costs cost of each of the routes
+   * @param route_loads total demand of the nodes of each of the routes
+   * @return Evaluation cost and validity of the chromosome
+   * @details The cost of the chromosome is identical to the one calculated by
+   * the other overloads
+   */
+  Evaluation<Cost> Evaluate(const std::vector<Gene> &chromosome,
+                            const std::vector<Gene> &iterators,
+                            std::vector<Cost> &route_costs,
+                            std::vector<int> &route_loads) const;
+
+  /**
+   * @brief Evaluates a batch of chromosomes
+   * @param chromosomes chromosomes to be evaluated, all of the same length
+   * @param iterators iterator vectors of the chromosomes; chromosomes can be
+   * split into different numbers of routes
+   * @param evaluations cost and validity of each of the chromosomes
+   * @return void
+   */
+  void Evaluate(const std::vector<std::vector<Gene>> &chromosomes,
+                const std::vector<std::vector<Gene>> &iterators,
+                std::vector<Evaluation<Cost>> &evaluations) const;
+
+  /**
+   * @brief Cost of travelling between two nodes
+   * @param i id of the first node
+   * @param j id of the second node
+   * @return Cost cost, as used in the evaluations
+   */
+  Cost Distance(const int i, const int j) const {
+    return static_cast<Cost>(distances_[static_cast<size_t>(i) * n_ + j]);
+  }
+
+  /**
+   * @brief Demand of a node
+   * @param i id of the node
+   * @return int demand
+   */
+  int Demand(const int i) const { return demands_[i]; }
+
+ private:
+  size_t n_;
+  int capacity_;
+  bool gather_;  // whether the flat matrix can be indexed by AVX2 gathers
+  std::vector<float> distances_;  // converted to Cost, held in single precision
+  std::vector<int> demands_;
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+  /**
+   * @brief Evaluates 8 chromosomes at once using AVX2 gathers
+   * @param chromosomes chromosomes to be evaluated
+   * @param iterators iterator vectors of the chromosomes
+   * @param first index of the first chromosome of the batch
+   * @param evaluations cost and validity of each of the chromosomes
+   * @return void
+   */
+  __attribute__((target("avx2"))) void EvaluateAVX2(
+      const std::vector<std::vector<Gene>> &chromosomes,
+      const std::vector<std::vector<Gene>> &iterators, const size_t first,
+      std::vector<Evaluation<Cost>> &evaluations) const;
+#endif
+};
+
+#endif  // BATCH_EVALUATOR_HPP
@@ -0,0 +1,94 @@
+/**
+ * @file cost.hpp
+ * @author vss2sn
+ * @brief Contains the types that can be used by the solvers for the costs of
+ * routes and moves
+ */
+
+#ifndef COST_HPP
+#define COST_HPP
+
+#include <cmath>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @brief Type used for costs within the solvers
+ * @details DOUBLE and FLOAT use the euclidean distances. ROUNDED rounds the
+ * distances to the nearest integer (as in CVRPLIB instances) and calculates
+ * costs using int32_t, which allows exact comparisons.
+ */
+enum class CostType { DOUBLE, FLOAT, ROUNDED };
+
+/**
+ * @brief Converts a distance into a cost
+ * @param distance distance between two nodes
+ * @return Cost distance as a cost, rounded to the nearest integer for integral
+ * costs
+ */
+template <typename Cost>
+inline Cost ToCost(const double distance) {
+  if constexpr (std::is_integral_v<Cost>) {
+    return static_cast<Cost>(std::lround(distance));
+  } else {
+    return static_cast<Cost>(distance);
+  }
+}
+
+/**
+ * @brief Checks whether a change in cost is an improvement
+ * @param delta change in cost
+ * @return bool True if the change reduces the cost
+ * @details Floating point changes need to be larger than a margin of error so
+ * that moves are not repeated because of rounding errors. Integral changes are
+ * compared exactly.
+ */
+template <typename Cost>
+constexpr bool IsImprovement(const Cost delta) {
+  if constexpr (std::is_integral_v<Cost>) {
+    return delta < 0;
+  } else if constexpr (std::is_same_v<Cost, float>) {
+    constexpr float margin_of_error = 0.001F;
+    return delta < -margin_of_error;
+  } else {
+    constexpr double margin_of_error = 0.00001;
+    return delta < -margin_of_error;
+  }
+}
+
+/**
+ * @brief class CostMatrix
+ * @details Flat copy of the distance matrix converted to a cost type
+ */
+template <typename Cost>
+class CostMatrix {
+ public:
+  /**
+   * @brief Constructor
+   * @param distanceMatrix Matrix containing distance between each pair of nodes
+   * @return no return value
+   */
+  explicit CostMatrix(const std::vector<std::vector<double>>& distanceMatrix)
+      : n_(distanceMatrix.size()), costs_(n_ * n_) {
+    for (size_t i = 0; i < n_; i++) {
+      for (size_t j = 0; j < n_; j++) {
+        costs_[i * n_ + j] = ToCost<Cost>(distanceMatrix[i][j]);
+      }
+    }
+  }
+
+  /**
+   * @brief Cost of travelling between two nodes
+   * @param i id of the first node
+   * @param j id of the second node
+   * @return Cost cost
+   */
+  Cost operator()(const int i, const int j) const { return costs_[i * n_ + j]; }
+
+ private:
+  size_t n_;
+  std::vector<Cost> costs_;
+};
+
+#endif  // COST_HPP
@@ -0,0 +1,49 @@
+/**
+ * @file education.hpp
+ * @author vss2sn
+ * @brief Contains the local search used to educate (improve) the routes of a
+ * solution, as used by the memetic mode of the genetic algorithm
+ */
+
+#ifndef EDUCATION_HPP
+#define EDUCATION_HPP
+
+#include <vector>
+
+#include "cvrp/neighbor_lists.hpp"
+#include "cvrp/utils.hpp"
+
+/**
+ * @brief struct EducationParameters
+ * @details Controls whether offspring are educated and how much work is spent
+ * on each of them. A budget of 0 means the corresponding limit is not applied.
+ */
+struct EducationParameters {
+ public:
+  bool enabled_ = false;
+  int move_budget_ = 1000;
+  double time_budget_ = 0;  // seconds
+};
+
+/**
+ * @brief Improves a set of routes using route local moves
+ * @param vehicles Vehicles whose routes are to be improved. Each route must
+ * start and end at the depot (empty routes are stored as {0, 0}).
+ * @param nodes Vector of all nodes
+ * @param distanceMatrix Matrix containing distance between each pair of nodes
+ * @param neighbors Nearest neighbors of each node
+ * @param params Move and time budget of the improvement
+ * @return int number of improving moves applied
+ * @details Repeatedly applies the first improving 2-opt move within a route,
+ * Or-opt move (segments of up to 3 nodes) within a route, or relocate move
+ * between routes until no improving move exists or the budget is exhausted.
+ * Only moves that create at least one edge between neighbors are considered.
+ * Loads (remaining capacity) and costs of the vehicles are kept up to date and
+ * no move that exceeds the capacity of a vehicle is applied.
+ */
+int EducateRoutes(std::vector<Vehicle> &vehicles, const std::vector<Node> &nodes,
+                  const std::vector<std::vector<double>> &distanceMatrix,
+                  const NeighborLists &neighbors,
+                  const EducationParameters &params);
+
+#endif  // EDUCATION_HPP
@@ -7,101 +7,324 @@
 #ifndef GENETIC_ALGORITHM_HPP
 #define GENETIC_ALGORITHM_HPP
 
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <limits>
+#include <memory>
+#include <random>
+#include <string>
 #include <unordered_set>
+#include <utility>
 
+#include "cvrp/batch_evaluator.hpp"
+#include "cvrp/education.hpp"
+#include "cvrp/kd_tree.hpp"
 #include "cvrp/utils.hpp"
 
-// Still need to account for case if nodes cannot be put into vehilces due to
-// small number of vehicles in initial solution
-class GASolution : public Solution {
+class GASolution;
+
+/**
+ * @brief struct PenaltyParameters
+ * @details Controls the search through infeasible solutions. When enabled, the
+ * operators no longer repair the routes of a solution; each unit of load in
+ * excess of the capacity of a vehicle is charged a penalty instead, and
+ * chromosomes are split into the routes with the lowest penalised cost. Feasible
+ * and infeasible solutions form separate subpopulations, and the penalty is
+ * adjusted every adjustment_interval_ generations so that the share of
+ * feasible offspring approaches target_feasible_.
+ */
+struct PenaltyParameters {
  public:
+  bool enabled_ = false;
+  double initial_penalty_ = 0;  // 0 derives it from the instance
+  double target_feasible_ = 0.2;
+  int adjustment_interval_ = 100;
+  double max_infeasible_share_ = 0.5;  // of the population
+};
+
+/**
+ * @brief class GAKernelBase
+ * @details Interface to the population and the operators of GASolution that
+ * does not depend on the type used to store the node indices
+ */
+class GAKernelBase {
+ public:
+  virtual ~GAKernelBase() = default;
+
   /**
-   * @brief Constructor
-   * @param nodes Vector of nodes
-   * @param vehicles Vector of vehicles
-   * @param distanceMatrix Matrix containing distance between each pair of nodes
-   * @param n_chromosomes Number of solutions
-   * @param generations Number of generations the algorithm should run for
-   * @return No return parameter
-   * @details Constructor for initial setup of problem, and solution using GA.
+   * @brief Runs the genetic algorithm and stores the best solution in the
+   * vehicles of the GASolution
+   * @return void
    */
-  GASolution(const std::vector<Node>& nodes,
-             const std::vector<Vehicle>& vehicles,
-             const std::vector<std::vector<double>>& distanceMatrix,
-             const int n_chromosomes = 10, const int generations = 100);
+  virtual void Solve() = 0;
+
   /**
-   * @brief Constructor
-   * @param p Instance of Problem class defining the problem parameters
-   * @param n_chromosomes Number of solutions
-   * @param generations Number of generations the algorithm should run for
-   * @return No return parameter
-   * @details Constructor
+   * @brief Runs generations until the time budget or the number of
+   * generations is used up, continuing from the previous call
+   * @param seconds wall-clock budget, 0 for no limit
+   * @param on_improvement called after the best solution has been stored in
+   * the vehicles of the GASolution, whenever the best solution improves; may
+   * be empty
+   * @return bool True if generations are left
    */
-  explicit GASolution(const Problem& p, const int n_chromosomes = 10,
-                      const int generations = 100);
+  virtual bool Step(const double seconds,
+                    const std::function<void()>& on_improvement) = 0;
+
+  /**
+   * @brief Sets up the education (memetic) step
+   * @param params Parameters of the education step
+   * @return void
+   */
+  virtual void SetEducation(const EducationParameters& params) = 0;
+
+  /**
+   * @brief Sets up the search through infeasible solutions
+   * @param params Parameters of the penalty
+   * @return void
+   */
+  virtual void SetPenalty(const PenaltyParameters& params) = 0;
 
+  /**
+   * @brief Limits the wall-clock time spent by Solve()
+   * @param seconds time after which no new generation is started, 0 for no
+   * limit
+   * @return void
+   */
+  virtual void SetTimeBudget(const double seconds) = 0;
+
+  /**
+   * @brief Replaces a solution of the population
+   * @param i index of the solution to be replaced
+   * @param chromosome order in which the nodes are visited
+   * @param iterators points at which the chromosome is split into routes
+   * @return bool True if the solution was valid and has been placed into the
+   * population
+   */
+  virtual bool Seed(const int i, const std::vector<int>& chromosome,
+                    const std::vector<int>& iterators) = 0;
+
+  /**
+   * @brief Number of solutions in the population
+   * @return int number of solutions
+   */
+  virtual int PopulationSize() const = 0;
+
+  /**
+   * @brief Writes the state of the algorithm
+   * @param os binary stream written to
+   * @return void
+   * @details Writes a header describing the instance and the types used,
+   * followed by the population, the generation, the penalty and education
+   * settings, the counters used to adjust the penalty and the state of the
+   * random number generator, in native byte order
+   */
+  virtual void Save(std::ostream& os) const = 0;
+
+  /**
+   * @brief Restores the state written by Save()
+   * @param is binary stream read from
+   * @return bool True if the state was read and matches the instance; the
+   * kernel should not be used otherwise
+   * @details The instance is matched by a hash of the coordinates and demands
+   * of the nodes. Every solution must be a permutation of the customers with
+   * non-decreasing iterators; the costs are recalculated rather than read.
+   */
+  virtual bool Load(std::istream& is) = 0;
+
+  /**
+   * @brief Sets up periodic checkpoints
+   * @param path file the checkpoints are written to, empty to disable them
+   * @param interval seconds between checkpoints
+   * @return void
+   */
+  virtual void SetCheckpoint(const std::string& path,
+                             const double interval) = 0;
+};
+
+/**
+ * @brief class GAKernel
+ * @details Population and operators of the genetic algorithm. Chromosomes and
+ * iterator vectors store node indices and positions as Gene, so that small and
+ * medium instances (up to 65536 nodes) can use 16 bit genes; the width is
+ * picked by GASolution from the size of the instance. Costs of the
+ * chromosomes are calculated as Cost (double, float or int32_t), picked from
+ * the cost type of the problem. Iterator vectors only describe the routes in
+ * use: every route holds at least one node, and vehicles are added as they are
+ * required up to the size of the fleet. Works on the nodes, vehicles and
+ * distance matrix of the GASolution that owns it.
+ */
+template <typename Gene, typename Cost>
+class GAKernel : public GAKernelBase {
+ public:
   /**
    * @brief Constructor
-   * @param s Instance of Solution class containing a valid solution and problem
-   * parameters
+   * @param s GASolution whose problem is to be solved
    * @param n_chromosomes Number of solutions
    * @param generations Number of generations the algorithm should run for
+   * @param generate_population False if the population is going to be loaded
    * @return No return parameter
-   * @details Constructor
+   * @details Generates the initial population
    */
-  explicit GASolution(const Solution& s, const int n_chromosomes = 10,
-                      const int generations = 100);
+  GAKernel(GASolution& s, const int n_chromosomes, const int generations,
+           const bool generate_population = true);
 
-  /**
-   * @brief Function called to solve the given problem using Genetic Algorithm
-   * @return void
-   * @details Generates random iniitial solutions. Applies selected algorithm.
-   * Prints cost of best solution, and its validity.
-   */
   void Solve() override;
 
+  bool Step(const double seconds,
+            const std::function<void()>& on_improvement) override;
+
+  void SetEducation(const EducationParameters& params) override {
+    education_ = params;
+  }
+
+  void SetPenalty(const PenaltyParameters& params) override;
+
+  void SetTimeBudget(const double seconds) override { time_budget_ = seconds; }
+
+  bool Seed(const int i, const std::vector<int>& chromosome,
+            const std::vector<int>& iterators) override;
+
+  int PopulationSize() const override { return chromosomes_.size(); }
+
+  void Save(std::ostream& os) const override;
+
+  bool Load(std::istream& is) override;
+
+  void SetCheckpoint(const std::string& path, const double interval) override {
+    checkpoint_path_ = path;
+    checkpoint_interval_ = interval;
+    last_checkpoint_ = std::chrono::steady_clock::now();
+  }
+
  private:
+  const Solution& solution_;
+  std::vector<Node>& nodes_;
+  std::vector<Vehicle>& vehicles_;
+  const std::vector<std::vector<double>>& distanceMatrix_;
+  const NeighborLists& neighbors_;
+  const Node& depot_;
+  const int capacity_;
   const int n_chromosomes_;
+  const int generations_;
   const size_t n_nucleotide_pairs_;
-  std::vector<double> costs_;
-  const size_t n_vehicles_;
-  std::vector<std::vector<int>> chromosomes_;
-  std::vector<std::vector<int>> iterators_;
+  std::vector<Cost> costs_;
+  const size_t n_vehicles_;  // size of the fleet
+  int min_routes_ = 1;       // vehicles needed to carry the total demand
+  std::vector<std::vector<Gene>> chromosomes_;
+  std::vector<std::vector<Gene>> iterators_;
   int best_ = 0;
+  int generation_ = 0;
+  Cost reported_cost_ = std::numeric_limits<Cost>::max();  // by Step()
+  EducationParameters education_;
+  double time_budget_ = 0;  // seconds, 0 for no limit
+  BatchEvaluator<Gene, Cost> evaluator_;
+
+  std::vector<int> excess_;  // load in excess of capacity, per chromosome
+  PenaltyParameters penalty_;
+  double penalty_weight_ = 0;
+  Cost penalty_cost_ = 0;  // charged per unit of excess load
+  int n_children_ = 0;
+  int n_feasible_children_ = 0;
+  // Used instead of rand() so that its state can be saved in a checkpoint
+  mutable std::default_random_engine rng_;
+  std::string checkpoint_path_;  // empty if no checkpoints are written
+  double checkpoint_interval_ = 0;  // seconds
+  std::chrono::steady_clock::time_point last_checkpoint_;
+
+  /**
+   * @brief struct Incumbent
+   * @details Best feasible solution found, kept when infeasible solutions are
+   * allowed into the population
+   */
+  struct Incumbent {
+   public:
+    std::vector<Gene> chromosome_;
+    std::vector<Gene> iterators_;
+    Cost cost_ = 0;
+    bool found_ = false;
+  };
+  Incumbent incumbent_;
+
+  /**
+   * @brief struct Routes
+   * @details Cost and load of each route of a chromosome, cached when the
+   * chromosome is evaluated so that moving a route boundary only updates the
+   * two routes involved
+   */
+  struct Routes {
+   public:
+    std::vector<Cost> costs_;
+    std::vector<int> loads_;
+    // Max heap of (cost, route). Entries whose cost no longer matches the
+    // route are stale and skipped.
+    std::vector<std::pair<Cost, int>> longest_;
+    bool valid_ = false;
+  };
+  std::vector<Routes> routes_;  // one per chromosome
 
   /**
-   * @brief Generates random solutions
+   * @brief Generates the initial population
    * @return void
-   * @details Generates random solutions for the initial setup of the problem.
-   * Atttempts to make sure all the solutions are valid, but no final check to
-   * ensure that they are not.
+   * @details Generates greedy solutions (20% of the population), the first
+   * starting at the depot and the others at a random node, and random
+   * solutions for the rest of the population, then attempts to make them valid
+   * and calculates their costs. Each solution is generated as an independent
+   * task with its own random number generator and its own copy of the spatial
+   * index of unrouted nodes, so all of them are generated concurrently.
    */
-  void GenerateRandomSolutions();
+  void GenerateInitialPopulation();
 
   /**
-   * @brief Generates greedy solutions with different start nodes (ie different
-   * first nodes after depot considered)
+   * @brief Generates a greedy solution
+   * @param i index of the solution to be generated
+   * @param first first node visited by the first vehicle (0 to pick the node
+   * closest to the depot)
+   * @param unrouted spatial index of the nodes to be routed
    * @return void
-   * @details Generates greedy solution for the initial setup of the problem.
-   * Atttempts to make sure all the solutions are valid, and exits the code if
-   * the solutions generated are invalid.
+   * @details Generates a greedy solution using a copy of the spatial index so
+   * that the nodes of the problem are not modified. The nodes that do not fit
+   * into the vehicles are appended to the last route, to be repaired by
+   * MakeValid().
    */
-  void GenerateGreedySolutions();
+  void GenerateGreedySolution(const int i, const int first, KdTree unrouted);
 
   /**
    * @brief Generates a random solution
-   * @return void
+   * @return std::vector<Gene> random chromosome
+   * @details Generates a random solution.
+   */
+  std::vector<Gene> GenerateRandomSolution() const;
+
+  /**
+   * @brief Generates a random solution
+   * @param rng random number generator to be used
+   * @return std::vector<Gene> random chromosome
    * @details Generates a random solution.
    */
-  std::vector<int> GenerateRandomSolution() const;
+  std::vector<Gene> GenerateRandomSolution(std::default_random_engine& rng) const;
 
   /**
    * @brief Generates a random iterator solution
-   * @return void
+   * @return std::vector<Gene> random iterator vector
    * @details Generates a random iterator solution containing the points using
    * which the chromosome is to be split into routes for the vehicles
    */
-  std::vector<int> GenerateRandomIterSolution() const;
+  std::vector<Gene> GenerateRandomIterSolution() const;
+
+  /**
+   * @brief Generates a random iterator solution
+   * @param rng random number generator to be used
+   * @return std::vector<Gene> random iterator vector
+   * @details Generates a random iterator solution containing the points using
+   * which the chromosome is to be split into routes for the vehicles. Splits
+   * the chromosome into at most as many routes as are needed to carry the total
+   * demand.
+   */
+  std::vector<Gene> GenerateRandomIterSolution(
+      std::default_random_engine& rng) const;
 
   /**
    * @brief Heuristic Greedy Crossover (HGreX)
@@ -109,7 +332,9 @@ class GASolution : public Solution {
    * @details Two parents are selected using tournament selection and a child is
    * created using the HGreX operator. If the solution is valid, the child is
    * added to the solutions. THe number of solutions is maintained using
-   * InsertionBySimilarity()
+   * InsertionBySimilarity(). When infeasible solutions are allowed, the child
+   * is split using Split() instead of being repaired and the number of
+   * solutions is maintained using SubpopulationSelection()
    */
   void HGreXCrossover();
 
@@ -180,8 +405,10 @@ class GASolution : public Solution {
   /**
    * @brief Split a route between 2 vehicles
    * @return void
-   * @details If there exits an unused vehicle (v), splits the route of a random
-   * vehicle between said random vehicle and v, if this improves the solution.
+   * @details If the fleet has an unused vehicle (v), splits the longest route
+   * of a random chromosome at a random point between said vehicle and v, if
+   * this does not increase the (penalised) cost of the solution. The longest
+   * route and the change in cost are found using the cached routes.
    */
   void InsertIterDist();
 
@@ -196,7 +423,11 @@ class GASolution : public Solution {
    * the previous gene into the succeeding nucleotide pair. Hence the last
    * visited node from the preceeding vehicle is moved into the route of the
    * current vehicle and is the first node visited by the current vehicle.
-   * Operation performed if solution is improved by said operation.
+   * Operation performed if solution is improved by said operation and the
+   * current vehicle can take the node (or, when infeasible solutions are
+   * allowed, if the penalised cost is improved). The change in cost is
+   * calculated in O(1) from the cached routes. If the preceeding route is left
+   * empty it is removed.
    */
   bool MutateIterLeft(const int i_chromosome, const int j_in);
 
@@ -211,22 +442,130 @@ class GASolution : public Solution {
    * the current gene into the preceeding nucleotide pair. Hence the first
    * visited node from the current vehicle is moved into the route of the
    * preceeding vehicle and is the last node visited by the preceeding vehicle.
-   * Operation performed if solution is improved by said operation.
+   * Operation performed if solution is improved by said operation and the
+   * preceeding vehicle can take the node (or, when infeasible solutions are
+   * allowed, if the penalised cost is improved). The change in cost is
+   * calculated in O(1) from the cached routes. If the current route is left
+   * empty it is removed.
    */
   bool MutateIterRight(const int i_chromosome, const int j_in);
 
+  /**
+   * @brief Calculates the cost and validity of a given solution
+   * @param i The solution to be evaluated
+   * @return Evaluation<Cost> calculated cost and validity
+   * @details Calculates the cost and the route loads in a single pass, and
+   * caches the cost and load of each route of the solution and its excess load
+   */
+  Evaluation<Cost> Evaluate(const int i);
+
+  /**
+   * @brief Penalised cost of an evaluated solution
+   * @param e cost, validity and excess load of the solution
+   * @return Cost cost including the penalty for the excess load
+   * @details The penalty is 0 unless infeasible solutions are allowed
+   */
+  Cost Fitness(const Evaluation<Cost>& e) const {
+    return e.cost_ + penalty_cost_ * static_cast<Cost>(e.excess_);
+  }
+
+  /**
+   * @brief Penalty charged for the load of a route above the capacity
+   * @param load total demand of the nodes of the route
+   * @return Cost penalty
+   */
+  Cost Penalty(const int load) const {
+    return penalty_cost_ * static_cast<Cost>(std::max(0, load - capacity_));
+  }
+
+  /**
+   * @brief Sets the penalty for excess load and updates the costs of all
+   * solutions
+   * @param weight penalty per unit of excess load
+   * @return void
+   */
+  void SetPenaltyWeight(const double weight);
+
+  /**
+   * @brief Adjusts the penalty towards the target share of feasible offspring
+   * @return void
+   * @details Increases the penalty if too few of the offspring since the last
+   * adjustment were feasible and decreases it if too many were
+   */
+  void AdjustPenalty();
+
+  /**
+   * @brief Finds the best solution
+   * @return void
+   * @details Updates the index of the solution with the lowest (penalised)
+   * cost and, when infeasible solutions are allowed, the best feasible solution
+   * found so far
+   */
+  void UpdateBest();
+
+  /**
+   * @brief Removes a solution from the population
+   * @param i index of the solution to be removed
+   * @return void
+   */
+  void EraseChromosome(const int i);
+
+  /**
+   * @brief Keeps the sizes of the feasible and infeasible subpopulations
+   * @return void
+   * @details Called after a new chromosome is added. Removes the worst solution
+   * of the subpopulation of the new chromosome (possibly the new chromosome
+   * itself), unless the infeasible subpopulation is below its share of the
+   * population, in which case the worst feasible solution is removed
+   */
+  void SubpopulationSelection();
+
+  /**
+   * @brief Marks the cached routes of a solution as out of date
+   * @param i The solution that has been modified
+   * @return void
+   */
+  void Invalidate(const int i) { routes_[i].valid_ = false; }
+
+  /**
+   * @brief Cached routes of a solution
+   * @param i The solution whose routes are required
+   * @return Routes& cost and load of each route
+   * @details Evaluates the solution if its cached routes are out of date
+   */
+  Routes& CachedRoutes(const int i);
+
+  /**
+   * @brief Updates the cached cost of a route
+   * @param r cached routes of a solution
+   * @param k route to be updated
+   * @param cost new cost of the route
+   * @return void
+   */
+  void SetRouteCost(Routes& r, const int k, const Cost cost);
+
+  /**
+   * @brief Finds the longest route of a solution
+   * @param i The solution whose routes are to be searched
+   * @return int index of the route with the greatest cost
+   * @details O(1) amortised using the heap of the cached routes
+   */
+  int LongestRoute(const int i);
+
   /**
    * @brief Calculates the cost of a given solution
    * @param i The solution whose cost is to be calculated
-   * @return double calculated cost
-   * @details Calculates the cost of a given solution
+   * @return Cost calculated cost
+   * @details Calculates the cost of a given solution, including the penalty
+   * for excess load
    */
-  double CalculateCost(const int i) const;
+  Cost CalculateCost(const int i);
 
   /**
    * @brief Calculates the cost of all solutions
    * @return void
-   * @details Calculates and updates the cost of all solutions
+   * @details Calculates and updates the cost of all solutions as a single
+   * batch using the BatchEvaluator
    */
   void CalculateTotalCost();
 
@@ -272,13 +611,23 @@ class GASolution : public Solution {
   void DeleteRandomChromosome();
 
   /**
-   * @brief Converts the best solution into the usual format
+   * @brief Splits a chromosome into the routes of the vehicles
+   * @param i index of the solution to be split
+   * @return std::vector<Vehicle> vehicles with their routes, loads and costs
+   * @details One vehicle per route of the solution; every route starts and
+   * ends at the depot
+   */
+  std::vector<Vehicle> DecodeRoutes(const int i) const;
+
+  /**
+   * @brief Improves a solution using local search (education)
+   * @param i index of the solution to be educated
    * @return void
-   * @details Splits the chromosome with the lowest cost into the routes
-   * indicated by the corresponding iterator vector and places them into the
-   * routes of the vehicles
+   * @details Decodes the solution into routes, improves them using
+   * EducateRoutes() within the budget set in SetEducation() and writes the
+   * improved routes back into the chromosome and iterator vector
    */
-  void GenerateBestSolution();
+  void Educate(const int i);
 
   /**
    * @brief Checks whether a solution is valid
@@ -286,16 +635,18 @@ class GASolution : public Solution {
    * the nodes on each of the routes does not exceed vehicle capacity)
    * @details Checks whether a solution is valid
    */
-  bool checkValidity(const int i) const;
+  bool checkValidity(const int i);
 
   /**
    * @brief Attempts to make a solution valid
    * @param i index of solution to be made valid
    * @return void
    * @details Iterates over asolution from left right moving iterators left if
-   * the demand of a route is greater than the capacity of the vehicle, then
-   * iterates over asolution from right to left moving iterators right if the
-   * demand of a route is greater than the capacity of the vehicle. If the
+   * the demand of a route is greater than the capacity of the vehicle, adding a
+   * route when the last one is overloaded and the fleet has an unused vehicle.
+   * If no vehicle is left, iterates over asolution from right to left moving
+   * iterators right if the demand of a route is greater than the capacity of
+   * the vehicle. Empty routes are removed. If the
    * ordering of the nodes can give a possible solution, this method ensures
    * that it is found. Does not gaurentee a solution if the ordering is
    * impossible (for eg the total demand exceeds the total capacity of all the
@@ -303,8 +654,202 @@ class GASolution : public Solution {
    */
   void MakeValid(const int i);
 
-  public:
-    const int generations_;
+  /**
+   * @brief Splits a chromosome into routes at the lowest penalised cost
+   * @param i index of solution to be split
+   * @return void
+   * @details Used instead of MakeValid() when infeasible solutions are allowed.
+   * Finds the iterator vector that minimises the cost plus the penalty for
+   * excess load (Bellman split of the chromosome as a giant tour), allowing
+   * routes to be overloaded by up to 50%. Uses MakeValid() if more routes than
+   * there are vehicles would be required.
+   */
+  void Split(const int i);
+
+  /**
+   * @brief Converts the best solution into the usual format
+   * @return void
+   * @details Splits the chromosome with the lowest cost (the best feasible
+   * solution found when infeasible solutions are allowed) into the routes
+   * indicated by the corresponding iterator vector and places them into the
+   * routes of the vehicles
+   */
+  void GenerateBestSolution();
+};
+
+// Still need to account for case if nodes cannot be put into vehilces due to
+// small number of vehicles in initial solution
+class GASolution : public Solution {
+ public:
+  /**
+   * @brief Constructor
+   * @param nodes Vector of nodes
+   * @param vehicles Vector of vehicles
+   * @param distanceMatrix Matrix containing distance between each pair of nodes
+   * @param n_chromosomes Number of solutions
+   * @param generations Number of generations the algorithm should run for
+   * @return No return parameter
+   * @details Constructor for initial setup of problem, and solution using GA.
+   */
+  GASolution(const std::vector<Node>& nodes,
+             const std::vector<Vehicle>& vehicles,
+             const std::vector<std::vector<double>>& distanceMatrix,
+             const int n_chromosomes = 10, const int generations = 100);
+  /**
+   * @brief Constructor
+   * @param p Instance of Problem class defining the problem parameters
+   * @param n_chromosomes Number of solutions
+   * @param generations Number of generations the algorithm should run for
+   * @return No return parameter
+   * @details Constructor
+   */
+  explicit GASolution(const Problem& p, const int n_chromosomes = 10,
+                      const int generations = 100);
+
+  /**
+   * @brief Constructor
+   * @param s Instance of Solution class containing a valid solution and problem
+   * parameters
+   * @param n_chromosomes Number of solutions
+   * @param generations Number of generations the algorithm should run for
+   * @return No return parameter
+   * @details Constructor
+   */
+  explicit GASolution(const Solution& s, const int n_chromosomes = 10,
+                      const int generations = 100);
+
+  /**
+   * @brief Constructor
+   * @param p Instance of Problem class defining the problem parameters
+   * @param checkpoint file written by SaveCheckpoint() or by the periodic
+   * checkpoints for the same problem
+   * @return No return parameter
+   * @details Resumes the algorithm from the checkpoint: the population, the
+   * number of generations left and the settings are restored, so the run
+   * continues as it would have without the restart. Exits the code if the
+   * checkpoint cannot be read or was written for a different problem.
+   */
+  GASolution(const Problem& p, const std::string& checkpoint);
+
+  ~GASolution() override;
+
+  // The kernel refers to the nodes and vehicles of the solution
+  GASolution(const GASolution&) = delete;
+  GASolution& operator=(const GASolution&) = delete;
+
+  /**
+   * @brief Function called to solve the given problem using Genetic Algorithm
+   * @return void
+   * @details Generates random iniitial solutions. Applies selected algorithm.
+   * Prints cost of best solution, and its validity.
+   */
+  void Solve() override;
+
+  /**
+   * @brief Sets up the education (memetic) step
+   * @param params Parameters of the education step
+   * @return void
+   * @details When enabled, each child created by HGreXCrossover() has its
+   * routes improved by local search before it is inserted into the population
+   */
+  void SetEducation(const EducationParameters& params) {
+    kernel_->SetEducation(params);
+  }
+
+  /**
+   * @brief Sets up the search through infeasible solutions
+   * @param params Parameters of the penalty
+   * @return void
+   * @details When enabled, offspring and mutated solutions are not repaired;
+   * capacity violations are charged an adaptive penalty instead. The best
+   * feasible solution found is returned.
+   */
+  void SetPenalty(const PenaltyParameters& params) {
+    kernel_->SetPenalty(params);
+  }
+
+  /**
+   * @brief Limits the wall-clock time spent by Solve()
+   * @param seconds time after which no new generation is started, 0 for no
+   * limit
+   * @return void
+   * @details Solve() stops after the number of generations or the time
+   * budget, whichever comes first
+   */
+  void SetTimeBudget(const double seconds) { kernel_->SetTimeBudget(seconds); }
+
+  /**
+   * @brief Runs generations for a bounded amount of time, continuing from the
+   * previous call
+   * @param seconds wall-clock budget of the call
+   * @return bool True if generations are left
+   * @details The population is kept between calls. The best solution is
+   * stored in the vehicles, and the incumbent callback called, as soon as a
+   * generation improves it, so the first call reports the best solution of
+   * the initial population.
+   */
+  bool Step(const double seconds) override;
+
+  /**
+   * @brief Places solutions into the population in place of random ones
+   * @param solutions customers visited by each vehicle, without the depot, for
+   * each solution
+   * @return int number of solutions placed into the population
+   * @details Solutions replace the population from the end, where the random
+   * solutions are, and fill at most half of it so that the greedy solutions
+   * and some random ones are kept. Invalid solutions are skipped. Used to
+   * start from solutions of similar instances (see SolutionCache::Transfer).
+   */
+  int SeedPopulation(
+      const std::vector<std::vector<std::vector<int>>>& solutions);
+
+  /**
+   * @brief Writes the state of the algorithm to a file
+   * @param path file to be written
+   * @return bool True if the file was written
+   * @details The state is written to a temporary file that then replaces
+   * path, so an interrupted write never leaves a partial checkpoint behind
+   */
+  bool SaveCheckpoint(const std::string& path) const;
+
+  /**
+   * @brief Writes checkpoints periodically while the algorithm runs
+   * @param path file the checkpoints are written to, empty to disable them
+   * @param interval seconds between checkpoints
+   * @return void
+   * @details Checked after every generation by Solve() and Step()
+   */
+  void SetCheckpoint(const std::string& path, const double interval) {
+    kernel_->SetCheckpoint(path, interval);
+  }
+
+ private:
+  std::unique_ptr<GAKernelBase> kernel_;
+
+  template <typename Gene, typename Cost>
+  friend class GAKernel;
+
+  /**
+   * @brief Creates the kernel using the narrowest gene type that can index all
+   * the nodes, and with it the initial population
+   * @param n_chromosomes Number of solutions
+   * @param generate_population False if the population is going to be loaded
+   * @return void
+   */
+  void CreateKernel(const int n_chromosomes,
+                    const bool generate_population = true);
+
+  /**
+   * @brief Creates the kernel for the cost type of the problem
+   * @param n_chromosomes Number of solutions
+   * @param generate_population False if the population is going to be loaded
+   * @return void
+   */
+  template <typename Gene>
+  void CreateKernel(const int n_chromosomes, const bool generate_population);
+
+ public:
+  const int generations_;
 };
 
 #endif  // GENETIC_ALGORITHM_HPP
@@ -0,0 +1,108 @@
+/**
+ * @file kd_tree.hpp
+ * @author vss2sn
+ * @brief Contains the KdTree class, a spatial index over the locations of the
+ * nodes
+ */
+
+#ifndef KD_TREE_HPP
+#define KD_TREE_HPP
+
+#include <tuple>
+#include <vector>
+
+#include "cvrp/utils.hpp"
+
+/**
+ * @brief class KdTree
+ * @details Balanced 2-d tree stored implicitly in arrays: the median of the
+ * range [lo, hi) is stored at (lo + hi) / 2 and its children in the ranges on
+ * either side. Distances are the euclidean distances used for the distance
+ * matrix, ties are broken by node id. Nodes can be erased from the tree (eg
+ * once they have been routed); every subtree keeps the smallest demand of the
+ * nodes left in it so that searches skip subtrees with no feasible node.
+ */
+class KdTree {
+ public:
+  /**
+   * @brief Constructor
+   * @param nodes Vector of all nodes
+   * @param ids ids of the nodes to be indexed
+   * @return no return value
+   * @details Builds the tree in O(N log N)
+   */
+  KdTree(const std::vector<Node> &nodes, std::vector<int> ids);
+
+  /**
+   * @brief Finds the nearest nodes to a location
+   * @param x x coordinate of the location
+   * @param y y coordinate of the location
+   * @param k number of nodes to be found
+   * @param exclude id of a node to be ignored (-1 to ignore none)
+   * @return std::vector<int> ids of at most k nodes, nearest first
+   */
+  std::vector<int> Nearest(const float x, const float y, const size_t k,
+                           const int exclude = -1) const;
+
+  /**
+   * @brief Finds the nearest node to a location whose demand can be met
+   * @param x x coordinate of the location
+   * @param y y coordinate of the location
+   * @param max_demand largest demand that can be met
+   * @return tuple containing bool as to whether a node was found and its id
+   * @details Only nodes that have not been erased are considered
+   */
+  std::tuple<bool, int> NearestFeasible(const float x, const float y,
+                                        const float max_demand) const;
+
+  /**
+   * @brief Erases a node from the tree
+   * @param id id of the node to be erased
+   * @return void
+   * @details Updates the smallest demand of the subtrees containing the node
+   * in O(log N). Erasing a node that is not in the tree has no effect.
+   */
+  void Erase(const int id);
+
+  /**
+   * @brief Number of nodes in the tree
+   * @return size_t number of nodes
+   */
+  size_t Size() const { return ids_.size(); }
+
+ private:
+  std::vector<int> ids_;
+  std::vector<float> x_, y_, demand_;
+  std::vector<unsigned char> axis_;
+  std::vector<bool> erased_;
+  std::vector<float> min_demand_;  // smallest demand left in each subtree
+  std::vector<int> left_, right_, parent_;
+  std::vector<int> position_;  // position of each node id in the tree
+
+  /**
+   * @brief Builds the subtree over the range [lo, hi)
+   * @param lo first index of the range
+   * @param hi index past the end of the range
+   * @param parent position of the parent of the subtree (-1 for the root)
+   * @return int position of the root of the subtree (-1 if empty)
+   */
+  int Build(const int lo, const int hi, const int parent);
+
+  /**
+   * @brief Recomputes the smallest demand left in a subtree
+   * @param i position of the root of the subtree
+   * @return void
+   */
+  void UpdateMinDemand(const int i);
+
+  /**
+   * @brief Squared distance between a location and the node at a position
+   * @param x x coordinate of the location
+   * @param y y coordinate of the location
+   * @param i position in the tree
+   * @return double squared distance
+   */
+  double Distance2(const float x, const float y, const int i) const;
+};
+
+#endif  // KD_TREE_HPP
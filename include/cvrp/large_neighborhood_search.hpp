@@ -0,0 +1,117 @@
+/**
+ * @file large_neighborhood_search.hpp
+ * @author vss2sn
+ * @brief Contains the LNSSolution (Large Neighborhood Search Solution) class
+ */
+
+#ifndef LNS_HPP
+#define LNS_HPP
+
+#include "cvrp/utils.hpp"
+
+/**
+ * @brief struct LNSParameters
+ * @details Size of the ruin, insertion rule, acceptance and budget of the
+ * large neighborhood search. Between min_removed_ and max_removed_ customers
+ * are removed per iteration. Customers are reinserted using regret-k
+ * insertion; a regret_k_ of 1 is greedy insertion. A solution is accepted if
+ * its cost is within threshold_ (a fraction of the best cost, decreased
+ * linearly to 0 over the run) of the best cost. The search stops when either
+ * budget is used up; a budget of 0 means the corresponding limit is not
+ * applied. If neither is set, the default iteration budget is used.
+ */
+struct LNSParameters {
+ public:
+  int min_removed_ = 10;
+  int max_removed_ = 30;
+  int max_string_length_ = 10;
+  int regret_k_ = 3;
+  double threshold_ = 0.001;
+  long long iteration_budget_ = 50000;
+  double time_budget_ = 0;  // seconds
+};
+
+class LNSSolution : public Solution {
+ public:
+  /**
+   * @brief Constructor
+   * @param nodes Vector of nodes
+   * @param vehicles Vector of vehicles
+   * @param distanceMatrix Matrix containing distance between each pair of nodes
+   * @param params Ruin size, insertion, acceptance and budget
+   * @return No return parameter
+   * @details Constructor for initial setup of problem, and solution using
+   * Large Neighborhood Search
+   */
+  LNSSolution(const std::vector<Node>& nodes,
+              const std::vector<Vehicle>& vehicles,
+              const std::vector<std::vector<double>>& distanceMatrix,
+              const LNSParameters& params = LNSParameters());
+
+  /**
+   * @brief Constructor
+   * @param p Instance of Problem class defining the problem parameters
+   * @param params Ruin size, insertion, acceptance and budget
+   * @return No return parameter
+   * @details Constructor for initial setup of problem, and solution using
+   * Large Neighborhood Search
+   */
+  explicit LNSSolution(const Problem& p,
+                       const LNSParameters& params = LNSParameters());
+
+  /**
+   * @brief Constructor
+   * @param s Instance of Solution class containing a valid solution and problem
+   * parameters
+   * @param params Ruin size, insertion, acceptance and budget
+   * @return No return parameter
+   * @details Constructor for initial setup of problem, and solution using
+   * Large Neighborhood Search
+   */
+  explicit LNSSolution(const Solution& s,
+                       const LNSParameters& params = LNSParameters());
+
+  /**
+   * @brief Function called to solve the given problem using large
+   * neighborhood search
+   * @return void
+   * @details Improves the initial solution. Prints cost of best solution, and
+   * its validity.
+   */
+  void Solve() override;
+
+  /**
+   * @brief Runs the large neighborhood search for a bounded amount of time,
+   * starting from the best solution found so far
+   * @param seconds wall-clock budget of the call
+   * @return bool True, as another call can find a better solution
+   * @details The search restarts from the best solution at every call, and the
+   * acceptance threshold decreases over each call. The incumbent callback is
+   * called at the end of a call that improved the solution.
+   */
+  bool Step(const double seconds) override;
+
+ private:
+  LNSParameters params_;
+
+  /**
+   * @brief Runs the large neighborhood search and stores the best solution
+   * found in the vehicles
+   * @return void
+   * @details Every iteration ruins the solution with one of three operators,
+   * picked at random: removal of random customers, removal of a customer and
+   * its nearest neighbors (radial), or removal of strings of consecutive
+   * customers from the routes of a customer and its nearest neighbors. The
+   * removed customers are then reinserted. A customer is only inserted next
+   * to one of its nearest neighbors or into an empty route, unless neither is
+   * possible. The best insertion of every removed customer into every route
+   * is cached, and only the entries of the route that received a customer are
+   * recalculated after each insertion. Rejected iterations are undone by
+   * reverting the removals and insertions, so an iteration only touches the
+   * routes it changed. Costs are calculated as Cost.
+   */
+  template <typename Cost>
+  void Search();
+};
+
+#endif  // LNS_HPP
@@ -52,6 +52,27 @@ class LocalSearchInterIntraSolution : public Solution {
    * Prints cost of best solution, and its validity.
    */
   void Solve() override;
+
+ private:
+  /**
+   * @brief Improves the routes of the vehicles
+   * @return void
+   * @details Variable neighborhood descent over relocation of a node, 2-opt*,
+   * swap, Or-opt and CROSS-exchange. The best move of the first neighborhood
+   * that reduces the cost is applied, after which the descent restarts from
+   * relocation; it stops when no neighborhood reduces the cost. Costs of the
+   * moves are calculated as Cost. Every move places a node next to one of its
+   * nearest neighbors. The best move between every pair of routes is cached
+   * per neighborhood; after a move only the pairs involving the two changed
+   * routes are recalculated, and only nodes of those routes or with a neighbor
+   * in them have their don't look bits cleared and are evaluated again. When
+   * many nodes are to be evaluated they are split by route across the thread
+   * pool; the result is the same as that of a serial evaluation. The moves
+   * are applied to a RouteSet and copied back into the vehicles once no move
+   * is left.
+   */
+  template <typename Cost>
+  void Improve();
 };
 
 #endif  // LSII_HPP
@@ -52,6 +52,18 @@ class LocalSearchIntraSolution : public Solution {
    * Prints cost of best solution, and its validity.
    */
   void Solve() override;
+
+ private:
+  /**
+   * @brief Improves the routes of the vehicles
+   * @return void
+   * @details Repeatedly moves the node that gives the largest reduction in
+   * cost to another position within its route, until no move reduces the
+   * cost. Costs of the moves are calculated as Cost. The moves are applied
+   * to a Route and copied back into the vehicle once no move is left.
+   */
+  template <typename Cost>
+  void Improve();
 };
 
 #endif  // LSI_HPP
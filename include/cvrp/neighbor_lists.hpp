@@ -0,0 +1,90 @@
+/**
+ * @file neighbor_lists.hpp
+ * @author vss2sn
+ * @brief Contains the NeighborLists class holding the k nearest customers of
+ * every node, used to restrict searches to granular neighborhoods
+ */
+
+#ifndef NEIGHBOR_LISTS_HPP
+#define NEIGHBOR_LISTS_HPP
+
+#include <vector>
+
+#include "cvrp/utils.hpp"
+
+constexpr size_t default_n_neighbors = 30;
+
+/**
+ * @brief struct NeighborRange
+ * @details Read only view of the neighbors of a node, nearest first
+ */
+struct NeighborRange {
+ public:
+  const int *begin_, *end_;
+
+  const int *begin() const { return begin_; }
+  const int *end() const { return end_; }
+  size_t size() const { return end_ - begin_; }
+};
+
+/**
+ * @brief class NeighborLists
+ * @details Stores the k nearest customers (nodes other than the depot) of each
+ * node, sorted by distance, in a single flat array. Built once per problem
+ * using a KdTree in O(N k log N).
+ */
+class NeighborLists {
+ public:
+  /**
+   * @brief Constructor
+   * @return no return value
+   * @details Constructs empty neighbor lists
+   */
+  NeighborLists() = default;
+
+  /**
+   * @brief Constructor
+   * @param nodes Vector of all nodes, the first of which is the depot
+   * @param k number of neighbors to be stored per node
+   * @return no return value
+   * @details Finds the k nearest customers of every node (including the
+   * depot). A node is never its own neighbor.
+   */
+  NeighborLists(const std::vector<Node> &nodes,
+                const size_t k = default_n_neighbors);
+
+  /**
+   * @brief Neighbors of a node
+   * @param node id of the node
+   * @return NeighborRange ids of the nearest customers, nearest first
+   */
+  NeighborRange Of(const int node) const {
+    return {neighbors_.data() + node * k_,
+            neighbors_.data() + node * k_ + k_};
+  }
+
+  /**
+   * @brief Checks whether a distance falls within the neighborhood of a node
+   * @param node id of the node
+   * @param distance distance from the node
+   * @return bool True if distance is no greater than the distance to the
+   * farthest of the neighbors of the node
+   * @details Allows granular checks of edges in constant time
+   */
+  bool WithinRadius(const int node, const double distance) const {
+    return distance <= radius_[node];
+  }
+
+  /**
+   * @brief Number of neighbors stored per node
+   * @return size_t number of neighbors
+   */
+  size_t K() const { return k_; }
+
+ private:
+  size_t k_ = 0;
+  std::vector<int> neighbors_;
+  std::vector<double> radius_;
+};
+
+#endif  // NEIGHBOR_LISTS_HPP
@@ -0,0 +1,135 @@
+/**
+ * @file pipeline.hpp
+ * @author vss2sn
+ * @brief Contains the Pipeline class, which chains solvers into a hybrid
+ */
+
+#ifndef PIPELINE_HPP
+#define PIPELINE_HPP
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "cvrp/utils.hpp"
+
+/**
+ * @brief struct StageReport
+ * @details Name of a stage of a pipeline, the time it took (construction of
+ * the solver and Solve()), and the cost and validity of its solution
+ */
+struct StageReport {
+ public:
+  std::string name_;
+  double seconds_ = 0;
+  double cost_ = 0;
+  bool valid_ = false;
+};
+
+/**
+ * @brief struct PipelineResult
+ * @details Outcome of a pipeline. If ok_ is false, error_ describes the stage
+ * that failed and the pipeline stopped there; stages_ contains the reports of
+ * the stages that ran, including the failing one. vehicles_ and cost_ are the
+ * routes and cost of the last valid solution.
+ */
+struct PipelineResult {
+ public:
+  bool ok_ = false;
+  std::string error_;
+  std::vector<StageReport> stages_;
+  std::vector<Vehicle> vehicles_;
+  double cost_ = 0;
+};
+
+class Pipeline {
+ public:
+  /**
+   * @brief Stage of a pipeline
+   * @details Creates a solver from the solution of the previous stage. The
+   * pipeline calls Solve() on the solver; returning nullptr stops the pipeline
+   * with an error.
+   */
+  using Stage = std::function<std::unique_ptr<Solution>(const Solution& s)>;
+
+  /**
+   * @brief Constructor
+   * @param p Instance of Problem class defining the problem parameters; has to
+   * outlive the pipeline
+   * @return No return parameter
+   */
+  explicit Pipeline(const Problem& p) : problem_(p) {}
+
+  /**
+   * @brief Appends a solver to the pipeline
+   * @param name name of the stage in the reports
+   * @param args arguments passed to the constructor of the solver after the
+   * solution or problem
+   * @return Pipeline& this pipeline, to chain calls
+   * @details The solver is constructed from the solution of the previous stage
+   * if it has such a constructor (eg local searches, metaheuristics); if it
+   * does not (eg savings, sweep), it is constructed from the problem and
+   * ignores the previous solution. The first stage that needs a solution
+   * starts from the greedy initial solution if no stage before it produced
+   * one.
+   */
+  template <typename S, typename... Args>
+  Pipeline& Then(const std::string& name, Args... args) {
+    if constexpr (std::is_constructible_v<S, const Solution&, Args...>) {
+      return Then(name, [args...](const Solution& s) {
+        return std::unique_ptr<Solution>(std::make_unique<S>(s, args...));
+      });
+    } else {
+      const Problem* p = &problem_;
+      stages_.push_back({name, nullptr, [p, args...]() {
+                           return std::unique_ptr<Solution>(
+                               std::make_unique<S>(*p, args...));
+                         }});
+      return *this;
+    }
+  }
+
+  /**
+   * @brief Appends a stage to the pipeline
+   * @param name name of the stage in the reports
+   * @param stage function creating the solver from the previous solution, eg
+   * to set up the solver before it is run
+   * @return Pipeline& this pipeline, to chain calls
+   */
+  Pipeline& Then(const std::string& name, const Stage& stage);
+
+  /**
+   * @brief Runs the stages in order
+   * @return PipelineResult reports of the stages and the final solution
+   * @details The solution of a stage is handed to the next one as the input
+   * of its constructor. Solutions share the distance matrix and the neighbor
+   * lists of the problem, so creating a stage copies only the routes and the
+   * nodes. The solvers exit the program when they are constructed from an
+   * invalid solution, so the input of every stage is checked first and an
+   * invalid one ends the pipeline with an error instead. The solvers run
+   * silently.
+   */
+  PipelineResult Run() const;
+
+ private:
+  /**
+   * @brief struct Step
+   * @details Stage with its name. Exactly one of the functions is set:
+   * from_solution_ if the solver uses the previous solution, from_problem_ if
+   * it only uses the problem.
+   */
+  struct Step {
+   public:
+    std::string name_;
+    Stage from_solution_;
+    std::function<std::unique_ptr<Solution>()> from_problem_;
+  };
+
+  const Problem& problem_;
+  std::vector<Step> stages_;
+};
+
+#endif  // PIPELINE_HPP
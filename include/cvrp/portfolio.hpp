@@ -0,0 +1,194 @@
+/**
+ * @file portfolio.hpp
+ * @author vss2sn
+ * @brief Contains the PortfolioSolution class, which runs several solvers
+ * concurrently, and the IncumbentBoard they share
+ */
+
+#ifndef PORTFOLIO_HPP
+#define PORTFOLIO_HPP
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "cvrp/utils.hpp"
+
+/**
+ * @brief class IncumbentBoard
+ * @details Best solution published by the solvers of a portfolio. Reading and
+ * publishing are lock free: the board holds an atomic pointer to an immutable
+ * entry, and a solution is published by swapping in a new entry with a
+ * compare and swap, as long as it is better than the entry it replaces.
+ * Replaced entries are only freed when the board is destroyed, so a reader
+ * never sees a freed entry.
+ */
+class IncumbentBoard {
+ public:
+  /**
+   * @brief struct Entry
+   * @details Published solution, the solver that found it and the entry it
+   * replaced
+   */
+  struct Entry {
+   public:
+    double cost_;
+    std::vector<Vehicle> vehicles_;
+    std::string solver_;
+    const Entry *previous_;
+  };
+
+  /**
+   * @brief Constructor
+   * @return no return value
+   */
+  IncumbentBoard() = default;
+
+  /**
+   * @brief Destructor
+   * @return no return value
+   * @details Frees all the entries ever published
+   */
+  ~IncumbentBoard();
+
+  IncumbentBoard(const IncumbentBoard&) = delete;
+  IncumbentBoard& operator=(const IncumbentBoard&) = delete;
+
+  /**
+   * @brief Publishes a solution if it is better than the best one
+   * @param cost total cost of the solution
+   * @param vehicles routes of the solution
+   * @param solver name of the solver that found it
+   * @return bool True if the solution is the new best one
+   */
+  bool Publish(const double cost, const std::vector<Vehicle>& vehicles,
+               const std::string& solver);
+
+  /**
+   * @brief Best solution published so far
+   * @return const Entry* best entry, nullptr if nothing has been published
+   */
+  const Entry *Best() const { return best_.load(std::memory_order_acquire); }
+
+ private:
+  std::atomic<const Entry *> best_{nullptr};
+};
+
+/**
+ * @brief struct PortfolioParameters
+ * @details Deadline of the portfolio and how often the solvers exchange
+ * solutions. Each solver is run repeatedly for slice_ seconds at a time and
+ * publishes its result to the board after every run. If pull_incumbent_ is
+ * set, a run starts from the best published solution whenever it is better
+ * than the solver's own.
+ */
+struct PortfolioParameters {
+ public:
+  double time_budget_ = 10;  // seconds
+  double slice_ = 2;         // seconds
+  bool pull_incumbent_ = true;
+};
+
+class PortfolioSolution : public Solution {
+ public:
+  /**
+   * @brief Solver of the portfolio
+   * @details Called with a valid solution to start from and a time budget in
+   * seconds. Returns the routes of the solution it found.
+   */
+  using Member = std::function<std::vector<Vehicle>(const Solution& start,
+                                                    const double seconds)>;
+
+  /**
+   * @brief Constructor
+   * @param nodes Vector of nodes
+   * @param vehicles Vector of vehicles
+   * @param distanceMatrix Matrix containing distance between each pair of nodes
+   * @param params Deadline and exchange of solutions
+   * @return No return parameter
+   * @details Constructor for initial setup of problem, and solution using a
+   * portfolio of solvers
+   */
+  PortfolioSolution(const std::vector<Node>& nodes,
+                    const std::vector<Vehicle>& vehicles,
+                    const std::vector<std::vector<double>>& distanceMatrix,
+                    const PortfolioParameters& params = PortfolioParameters());
+
+  /**
+   * @brief Constructor
+   * @param p Instance of Problem class defining the problem parameters
+   * @param params Deadline and exchange of solutions
+   * @return No return parameter
+   * @details Constructor for initial setup of problem, and solution using a
+   * portfolio of solvers
+   */
+  explicit PortfolioSolution(
+      const Problem& p,
+      const PortfolioParameters& params = PortfolioParameters());
+
+  /**
+   * @brief Constructor
+   * @param s Instance of Solution class containing a valid solution and problem
+   * parameters
+   * @param params Deadline and exchange of solutions
+   * @return No return parameter
+   * @details Constructor for initial setup of problem, and solution using a
+   * portfolio of solvers
+   */
+  explicit PortfolioSolution(
+      const Solution& s,
+      const PortfolioParameters& params = PortfolioParameters());
+
+  /**
+   * @brief Adds a solver to the portfolio
+   * @param name name of the solver, reported with its solutions
+   * @param member function running the solver
+   * @return void
+   */
+  void AddMember(const std::string& name, const Member& member);
+
+  /**
+   * @brief Function called to solve the given problem using the portfolio
+   * @return void
+   * @details Runs every member on its own thread until the deadline, starting
+   * from the initial solution, and keeps the best solution published. If no
+   * member has been added, two variants of the genetic algorithm, the inter
+   * route local search, simulated annealing, tabu search and large
+   * neighborhood search are run. Prints cost of best solution, and its
+   * validity.
+   */
+  void Solve() override;
+
+  /**
+   * @brief Board holding the best solution found by the portfolio
+   * @return const IncumbentBoard& board
+   */
+  const IncumbentBoard& Board() const { return board_; }
+
+ private:
+  PortfolioParameters params_;
+  std::vector<std::pair<std::string, Member>> members_;
+  IncumbentBoard board_;
+
+  /**
+   * @brief Adds the default solvers to the portfolio
+   * @return void
+   */
+  void AddDefaultMembers();
+
+  /**
+   * @brief Runs a member until the deadline
+   * @param name name of the member
+   * @param member function running the member
+   * @param deadline time at which the portfolio stops
+   * @return void
+   * @details A member that returns early without improving its starting
+   * solution is not run again until a better solution is published
+   */
+  void Run(const std::string& name, const Member& member,
+           const std::chrono::steady_clock::time_point deadline);
+};
+
+#endif  // PORTFOLIO_HPP
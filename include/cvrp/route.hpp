@@ -0,0 +1,289 @@
+/**
+ * @file route.hpp
+ * @author vss2sn
+ * @brief Contains the Route and RouteSet classes, array based routes with
+ * cumulative costs and loads used by the local searches
+ */
+
+#ifndef ROUTE_HPP
+#define ROUTE_HPP
+
+#include <vector>
+
+#include "cvrp/cost.hpp"
+#include "cvrp/utils.hpp"
+
+/**
+ * @brief class Route
+ * @details Nodes visited by a vehicle, starting and ending at the depot, along
+ * with the cumulative cost and load at every position of the route. The cost
+ * and the load of any segment of the route are available in O(1). Inserting or
+ * erasing a node only updates the cumulative values from the position that
+ * changed onwards.
+ */
+template <typename Cost>
+class Route {
+ public:
+  /**
+   * @brief Constructor
+   * @param nodes ids of the nodes visited, starting and ending at the depot
+   * @param all_nodes Vector of all nodes
+   * @param costs Cost of travelling between each pair of nodes
+   * @return no return value
+   */
+  Route(const std::vector<int> &nodes, const std::vector<Node> &all_nodes,
+        const CostMatrix<Cost> &costs);
+
+  /**
+   * @brief Node at a position of the route
+   * @param pos position in the route (0 is the depot)
+   * @return int id of the node
+   */
+  int operator[](const int pos) const { return nodes_[pos]; }
+
+  /**
+   * @brief Number of positions of the route, including both visits to the
+   * depot
+   * @return int number of positions
+   */
+  int Size() const { return nodes_.size(); }
+
+  /**
+   * @brief Cost of the route
+   * @return Cost cost of travelling the whole route
+   */
+  Cost Distance() const { return distance_.back(); }
+
+  /**
+   * @brief Cost of a segment of the route
+   * @param i first position of the segment
+   * @param j last position of the segment
+   * @return Cost cost of travelling from position i to position j
+   */
+  Cost Distance(const int i, const int j) const {
+    return distance_[j] - distance_[i];
+  }
+
+  /**
+   * @brief Load of the route
+   * @return int total demand of the nodes of the route
+   */
+  int Load() const { return load_.back(); }
+
+  /**
+   * @brief Load of a segment of the route
+   * @param i position before the segment
+   * @param j last position of the segment
+   * @return int total demand of the nodes at positions i + 1 to j
+   */
+  int Load(const int i, const int j) const { return load_[j] - load_[i]; }
+
+  /**
+   * @brief Nodes of the route
+   * @return const std::vector<int>& ids of the nodes, starting and ending at
+   * the depot
+   */
+  const std::vector<int> &Nodes() const { return nodes_; }
+
+  /**
+   * @brief Removes the node at a position
+   * @param pos position of the node to be removed
+   * @return void
+   */
+  void Erase(const int pos);
+
+  /**
+   * @brief Inserts a node at a position
+   * @param pos position the node will be at
+   * @param node id of the node to be inserted
+   * @return void
+   */
+  void Insert(const int pos, const int node);
+
+  /**
+   * @brief Replaces a segment of the route
+   * @param i position before the segment
+   * @param j last position of the segment
+   * @param segment ids of the nodes to be placed at positions i + 1 onwards
+   * @return void
+   */
+  void Replace(const int i, const int j, const std::vector<int> &segment);
+
+  /**
+   * @brief Reverses a segment of the route
+   * @param i first position of the segment
+   * @param j last position of the segment
+   * @return void
+   */
+  void Reverse(const int i, const int j);
+
+ private:
+  const std::vector<Node> *all_nodes_;
+  const CostMatrix<Cost> *costs_;
+  std::vector<int> nodes_;
+  std::vector<Cost> distance_;  // cost from the depot to each position
+  std::vector<int> load_;       // demand up to and including each position
+
+  /**
+   * @brief Recalculates the cumulative costs and loads
+   * @param from first position whose values are recalculated
+   * @return void
+   */
+  void Update(const int from);
+};
+
+/**
+ * @brief class RouteSet
+ * @details Routes of all the vehicles of a solution along with the route and
+ * position of every node, which are updated only for the routes changed by a
+ * move
+ */
+template <typename Cost>
+class RouteSet {
+ public:
+  /**
+   * @brief Constructor
+   * @param vehicles vehicles whose routes are to be copied
+   * @param nodes Vector of all nodes
+   * @param costs Cost of travelling between each pair of nodes
+   * @return no return value
+   */
+  RouteSet(const std::vector<Vehicle> &vehicles, const std::vector<Node> &nodes,
+           const CostMatrix<Cost> &costs);
+
+  /**
+   * @brief Route of a vehicle
+   * @param k index of the vehicle
+   * @return const Route<Cost>& route
+   */
+  const Route<Cost> &operator[](const int k) const { return routes_[k]; }
+
+  /**
+   * @brief Number of routes
+   * @return int number of routes
+   */
+  int Size() const { return routes_.size(); }
+
+  /**
+   * @brief Route a node is in
+   * @param node id of the node
+   * @return int index of the route, -1 if the node is not routed
+   */
+  int RouteOf(const int node) const { return route_of_[node]; }
+
+  /**
+   * @brief Position of a node in its route
+   * @param node id of the node
+   * @return int position, -1 if the node is not routed
+   */
+  int PositionOf(const int node) const { return pos_of_[node]; }
+
+  /**
+   * @brief Moves a node to another position
+   * @param node id of the node to be moved
+   * @param k index of the destination route
+   * @param after position in the destination route, before the move, after
+   * which the node is to be placed
+   * @return void
+   */
+  void Relocate(const int node, const int k, const int after);
+
+  /**
+   * @brief Removes a node from its route
+   * @param node id of the node to be removed
+   * @return void
+   * @details The node is no longer routed afterwards
+   */
+  void Remove(const int node);
+
+  /**
+   * @brief Inserts a node that is not routed into a route
+   * @param node id of the node to be inserted
+   * @param k index of the route
+   * @param after position after which the node is to be placed
+   * @return void
+   */
+  void Insert(const int node, const int k, const int after);
+
+  /**
+   * @brief Exchanges segments of two different routes
+   * @param k1 index of the first route
+   * @param i1 position before the segment of the first route
+   * @param j1 last position of the segment of the first route
+   * @param k2 index of the second route
+   * @param i2 position before the segment of the second route
+   * @param j2 last position of the segment of the second route
+   * @return void
+   * @details Either segment can be empty; the order of the nodes within each
+   * segment is kept
+   */
+  void Exchange(const int k1, const int i1, const int j1, const int k2,
+                const int i2, const int j2);
+
+  /**
+   * @brief Change in cost caused by exchanging segments of two different
+   * routes
+   * @param k1 index of the first route
+   * @param i1 position before the segment of the first route
+   * @param j1 last position of the segment of the first route
+   * @param k2 index of the second route
+   * @param i2 position before the segment of the second route
+   * @param j2 last position of the segment of the second route
+   * @return Cost change in the total cost of the routes
+   * @details Calculated in O(1) from the edges at the ends of the segments, as
+   * the cost within the segments does not change
+   */
+  Cost ExchangeDelta(const int k1, const int i1, const int j1, const int k2,
+                     const int i2, const int j2) const;
+
+  /**
+   * @brief Reverses a segment of a route
+   * @param k index of the route
+   * @param i first position of the segment
+   * @param j last position of the segment
+   * @return void
+   */
+  void Reverse(const int k, const int i, const int j);
+
+  /**
+   * @brief Copies the routes back into the vehicles
+   * @param vehicles vehicles the routes were copied from
+   * @param distanceMatrix Matrix containing distance between each pair of nodes
+   * @param capacity capacity of each vehicle
+   * @return void
+   * @details Updates the nodes, remaining capacity and cost of each vehicle
+   */
+  void WriteBack(std::vector<Vehicle> &vehicles,
+                 const std::vector<std::vector<double>> &distanceMatrix,
+                 const int capacity) const;
+
+ private:
+  const CostMatrix<Cost> *costs_;
+  std::vector<Route<Cost>> routes_;
+  std::vector<int> route_of_;
+  std::vector<int> pos_of_;
+
+  /**
+   * @brief Updates the positions of the nodes of a route
+   * @param k index of the route
+   * @param from first position to be updated
+   * @return void
+   */
+  void Locate(const int k, const int from);
+
+  /**
+   * @brief Cost of the edges joining the segment (k, l] of route b to route a
+   * in place of the segment (i, j] of route a
+   * @param a route the segment is placed into
+   * @param i position of route a before the segment
+   * @param j last position of the segment of route a
+   * @param b route the segment is taken from
+   * @param k position of route b before the segment
+   * @param l last position of the segment of route b
+   * @return Cost cost of the edges
+   */
+  Cost Link(const Route<Cost> &a, const int i, const int j,
+            const Route<Cost> &b, const int k, const int l) const;
+};
+
+#endif  // ROUTE_HPP
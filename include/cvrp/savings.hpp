@@ -0,0 +1,52 @@
+/**
+ * @file savings.hpp
+ * @author vss2sn
+ * @brief Contains the SavingsSolution class (Clarke-Wright savings algorithm)
+ */
+
+#ifndef SAVINGS_HPP
+#define SAVINGS_HPP
+
+#include "cvrp/utils.hpp"
+
+class SavingsSolution : public Solution {
+ public:
+  /**
+   * @brief Constructor
+   * @param nodes Vector of nodes
+   * @param vehicles Vector of vehicles
+   * @param distanceMatrix Matrix containing distance between each pair of nodes
+   * @return No return parameter
+   * @details Constructor for initial setup of problem, and solution using the
+   * savings algorithm
+   */
+  SavingsSolution(const std::vector<Node>& nodes,
+                  const std::vector<Vehicle>& vehicles,
+                  const std::vector<std::vector<double>>& distanceMatrix);
+
+  /**
+   * @brief Constructor
+   * @param p Instance of Problem class defining the problem parameters
+   * @return No return parameter
+   * @details Constructor for initial setup of problem, and solution using the
+   * savings algorithm
+   */
+  explicit SavingsSolution(const Problem& p);
+
+  /**
+   * @brief Function called to solve the given problem using the savings
+   * algorithm
+   * @return void
+   * @details Starts with one route per node and repeatedly merges the two
+   * routes with the largest saving d(0, i) + d(0, j) - d(i, j), where i and j
+   * are the ends of the routes being joined, as long as the merged route does
+   * not exceed the capacity of a vehicle. Only pairs of neighbors are
+   * considered, and the savings are kept in a heap whose entries are checked
+   * when they are popped rather than updated after every merge, so the
+   * algorithm runs in O(N k log(N k)). Routes are then assigned to the
+   * vehicles; nodes that do not fit in the fleet are left unrouted.
+   */
+  void Solve() override;
+};
+
+#endif  // SAVINGS_HPP
@@ -0,0 +1,119 @@
+/**
+ * @file simulated_annealing.hpp
+ * @author vss2sn
+ * @brief Contains the SimulatedAnnealingSolution class
+ */
+
+#ifndef SA_HPP
+#define SA_HPP
+
+#include "cvrp/utils.hpp"
+
+/**
+ * @brief Cooling schedules of the simulated annealing
+ * @details The temperature is a function of the progress of the search, the
+ * fraction of the move or time budget used so far. GEOMETRIC decreases the
+ * temperature by a constant factor per unit of progress, LINEAR by a constant
+ * amount.
+ */
+enum class CoolingSchedule { GEOMETRIC, LINEAR };
+
+/**
+ * @brief struct AnnealingParameters
+ * @details Cooling schedule and budget of the simulated annealing. The search
+ * stops when either budget is used up; a budget of 0 means the corresponding
+ * limit is not applied. If neither is set, the default move budget is used.
+ */
+struct AnnealingParameters {
+ public:
+  CoolingSchedule schedule_ = CoolingSchedule::GEOMETRIC;
+  double initial_temperature_ = 0;  // 0 derives it from the instance
+  double final_temperature_ = 0;    // 0 uses a fraction of the initial one
+  long long move_budget_ = 10000000;
+  double time_budget_ = 0;  // seconds
+};
+
+class SimulatedAnnealingSolution : public Solution {
+ public:
+  /**
+   * @brief Constructor
+   * @param nodes Vector of nodes
+   * @param vehicles Vector of vehicles
+   * @param distanceMatrix Matrix containing distance between each pair of nodes
+   * @param params Cooling schedule and budget
+   * @return No return parameter
+   * @details Constructor for initial setup of problem, and solution using
+   * Simulated Annealing
+   */
+  SimulatedAnnealingSolution(
+      const std::vector<Node>& nodes, const std::vector<Vehicle>& vehicles,
+      const std::vector<std::vector<double>>& distanceMatrix,
+      const AnnealingParameters& params = AnnealingParameters());
+
+  /**
+   * @brief Constructor
+   * @param p Instance of Problem class defining the problem parameters
+   * @param params Cooling schedule and budget
+   * @return No return parameter
+   * @details Constructor for initial setup of problem, and solution using
+   * Simulated Annealing
+   */
+  explicit SimulatedAnnealingSolution(
+      const Problem& p,
+      const AnnealingParameters& params = AnnealingParameters());
+
+  /**
+   * @brief Constructor
+   * @param s Instance of Solution class containing a valid solution and problem
+   * parameters
+   * @param params Cooling schedule and budget
+   * @return No return parameter
+   * @details Constructor for initial setup of problem, and solution using
+   * Simulated Annealing
+   */
+  explicit SimulatedAnnealingSolution(
+      const Solution& s,
+      const AnnealingParameters& params = AnnealingParameters());
+
+  /**
+   * @brief Function called to solve the given problem using simulated
+   * annealing
+   * @return void
+   * @details Improves the initial solution. Prints cost of best solution, and
+   * its validity.
+   */
+  void Solve() override;
+
+  /**
+   * @brief Runs the annealing for a bounded amount of time, starting from the
+   * best solution found so far
+   * @param seconds wall-clock budget of the call
+   * @return bool True, as another call can find a better solution
+   * @details The annealing restarts from the best solution at every call, so
+   * the temperature is reset. The incumbent callback is called at the end of a
+   * call that improved the solution.
+   */
+  bool Step(const double seconds) override;
+
+ private:
+  AnnealingParameters params_;
+
+  /**
+   * @brief Runs the simulated annealing and stores the best solution found in
+   * the vehicles
+   * @return void
+   * @details Each step picks a random node and one of its nearest neighbors
+   * and proposes a move that places the node next to the neighbor: a
+   * relocation of the node, a swap with the node on either side of the
+   * neighbor, or a 2-opt move (reversal of a segment within a route, or an
+   * exchange of the tails of two routes). The change in cost and the loads
+   * are calculated in constant time from the cumulative values of the
+   * routes, which are only updated when a move is accepted. Moves that exceed
+   * the capacity of a vehicle are rejected. Costs of the moves are calculated
+   * as Cost; distances are assumed to be symmetric.
+   */
+  template <typename Cost>
+  void Anneal();
+};
+
+#endif  // SA_HPP
@@ -0,0 +1,128 @@
+/**
+ * @file solution_cache.hpp
+ * @author vss2sn
+ * @brief Contains the SolutionCache class, an on-disk store of the best known
+ * solution of each instance
+ */
+
+#ifndef SOLUTION_CACHE_HPP
+#define SOLUTION_CACHE_HPP
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "cvrp/utils.hpp"
+
+/**
+ * @brief Customers visited by each vehicle, without the depot
+ */
+using Routes = std::vector<std::vector<int>>;
+
+/**
+ * @brief Content hash of an instance
+ * @param p Instance of Problem class defining the problem parameters
+ * @return uint64_t 64 bit FNV-1a hash of the coordinates and demands of the
+ * nodes (in the order of their ids), the capacity, the size of the fleet and
+ * the cost type
+ */
+uint64_t InstanceHash(const Problem& p);
+
+/**
+ * @brief Features of an instance used to find similar instances
+ * @param p Instance of Problem class defining the problem parameters
+ * @return std::vector<double> number of customers, capacity, size of the
+ * fleet, mean demand relative to the capacity, minimum number of routes, share
+ * of the capacity of the fleet that is used, mean and standard deviation of
+ * the distance of the customers to the depot, mean distance of a customer to
+ * its nearest customer, and distance of the depot to the centroid of the
+ * customers
+ */
+std::vector<double> InstanceFeatures(const Problem& p);
+
+/**
+ * @brief class CachedSolution
+ * @details Solution of a problem built from stored routes. Can be used as the
+ * starting solution of the solvers that take a Solution, eg GASolution.
+ */
+class CachedSolution : public Solution {
+ public:
+  /**
+   * @brief Constructor
+   * @param p Instance of Problem class defining the problem parameters
+   * @param routes customers visited by each vehicle, without the depot; at
+   * most one route per vehicle
+   * @return No return parameter
+   */
+  CachedSolution(const Problem& p, const Routes& routes);
+
+  /**
+   * @brief Does nothing, the routes are given
+   * @return void
+   */
+  void Solve() override {}
+};
+
+class SolutionCache {
+ public:
+  /**
+   * @brief Constructor
+   * @param directory directory holding one file per instance; created when
+   * the first solution is stored
+   * @return No return parameter
+   */
+  explicit SolutionCache(std::string directory);
+
+  /**
+   * @brief Best known solution of a problem
+   * @param p Instance of Problem class defining the problem parameters
+   * @return std::unique_ptr<CachedSolution> stored solution, nullptr if none
+   * is stored or the stored one is not a valid solution of the problem
+   */
+  std::unique_ptr<CachedSolution> Lookup(const Problem& p) const;
+
+  /**
+   * @brief Stores a solution of a problem if it is better than the stored one
+   * @param p Instance of Problem class defining the problem parameters
+   * @param s solution of the problem
+   * @return bool True if the solution was valid, better than the stored one,
+   * and has been written
+   * @details The file is written to a temporary file, unique to the call,
+   * that then replaces the stored one, so readers never see a partial file.
+   * The comparison with the stored solution is best effort: if several
+   * processes store a solution of the same instance at once, the last one to
+   * replace the file wins, even if its solution is worse.
+   */
+  bool Store(const Problem& p, const Solution& s) const;
+
+  /**
+   * @brief Solutions of the most similar cached instances, mapped onto a
+   * problem
+   * @param p Instance of Problem class defining the problem parameters
+   * @param n_neighbors maximum number of cached instances used
+   * @return std::vector<Routes> one solution per cached instance used, most
+   * similar instance first
+   * @details Instances are compared by the relative differences of their
+   * features; the entry of p itself is ignored. Coordinates are taken
+   * relative to the depot and scaled by the mean distance of the customers to
+   * the depot, each customer of p is matched to the nearest customer of the
+   * cached instance, and the customers are visited in the order of their
+   * matches. Routes are split where they exceed the capacity; solutions that
+   * need more vehicles than the fleet has are dropped.
+   */
+  std::vector<Routes> Transfer(const Problem& p,
+                               const size_t n_neighbors) const;
+
+  /**
+   * @brief File holding the solution of a problem
+   * @param p Instance of Problem class defining the problem parameters
+   * @return std::string path of the file
+   */
+  std::string Path(const Problem& p) const;
+
+ private:
+  std::string directory_;
+};
+
+#endif  // SOLUTION_CACHE_HPP
@@ -0,0 +1,50 @@
+/**
+ * @file sweep.hpp
+ * @author vss2sn
+ * @brief Contains the SweepSolution class (sweep algorithm)
+ */
+
+#ifndef SWEEP_HPP
+#define SWEEP_HPP
+
+#include "cvrp/utils.hpp"
+
+class SweepSolution : public Solution {
+ public:
+  /**
+   * @brief Constructor
+   * @param nodes Vector of nodes
+   * @param vehicles Vector of vehicles
+   * @param distanceMatrix Matrix containing distance between each pair of nodes
+   * @return No return parameter
+   * @details Constructor for initial setup of problem, and solution using the
+   * sweep algorithm
+   */
+  SweepSolution(const std::vector<Node>& nodes,
+                const std::vector<Vehicle>& vehicles,
+                const std::vector<std::vector<double>>& distanceMatrix);
+
+  /**
+   * @brief Constructor
+   * @param p Instance of Problem class defining the problem parameters
+   * @return No return parameter
+   * @details Constructor for initial setup of problem, and solution using the
+   * sweep algorithm
+   */
+  explicit SweepSolution(const Problem& p);
+
+  /**
+   * @brief Function called to solve the given problem using the sweep
+   * algorithm
+   * @return void
+   * @details Sorts the nodes by their polar angle around the depot, starting
+   * after the largest angular gap between two consecutive nodes, and fills the
+   * vehicles in that order, moving to the next vehicle when the next node does
+   * not fit. The order of the nodes within each route is then improved with
+   * 2-opt and Or-opt moves. Runs in O(N log N) plus the cost of the route
+   * improvement; nodes that do not fit in the fleet are left unrouted.
+   */
+  void Solve() override;
+};
+
+#endif  // SWEEP_HPP
@@ -0,0 +1,111 @@
+/**
+ * @file tabu_search.hpp
+ * @author vss2sn
+ * @brief Contains the TabuSearchSolution class
+ */
+
+#ifndef TS_HPP
+#define TS_HPP
+
+#include "cvrp/utils.hpp"
+
+/**
+ * @brief struct TabuParameters
+ * @details Tenure, candidate list and budget of the tabu search. The tenure of
+ * every attribute is drawn uniformly from [min_tenure_, max_tenure_]. The
+ * search stops when either budget is used up; a budget of 0 means the
+ * corresponding limit is not applied. If neither is set, the default
+ * iteration budget is used.
+ */
+struct TabuParameters {
+ public:
+  int min_tenure_ = 10;
+  int max_tenure_ = 20;
+  int n_candidates_ = 3;  // nodes whose moves are evaluated per iteration
+  long long iteration_budget_ = 200000;
+  double time_budget_ = 0;  // seconds
+};
+
+class TabuSearchSolution : public Solution {
+ public:
+  /**
+   * @brief Constructor
+   * @param nodes Vector of nodes
+   * @param vehicles Vector of vehicles
+   * @param distanceMatrix Matrix containing distance between each pair of nodes
+   * @param params Tenure, candidate list and budget
+   * @return No return parameter
+   * @details Constructor for initial setup of problem, and solution using Tabu
+   * Search
+   */
+  TabuSearchSolution(const std::vector<Node>& nodes,
+                     const std::vector<Vehicle>& vehicles,
+                     const std::vector<std::vector<double>>& distanceMatrix,
+                     const TabuParameters& params = TabuParameters());
+
+  /**
+   * @brief Constructor
+   * @param p Instance of Problem class defining the problem parameters
+   * @param params Tenure, candidate list and budget
+   * @return No return parameter
+   * @details Constructor for initial setup of problem, and solution using Tabu
+   * Search
+   */
+  explicit TabuSearchSolution(const Problem& p,
+                              const TabuParameters& params = TabuParameters());
+
+  /**
+   * @brief Constructor
+   * @param s Instance of Solution class containing a valid solution and problem
+   * parameters
+   * @param params Tenure, candidate list and budget
+   * @return No return parameter
+   * @details Constructor for initial setup of problem, and solution using Tabu
+   * Search
+   */
+  explicit TabuSearchSolution(const Solution& s,
+                              const TabuParameters& params = TabuParameters());
+
+  /**
+   * @brief Function called to solve the given problem using tabu search
+   * @return void
+   * @details Improves the initial solution. Prints cost of best solution, and
+   * its validity.
+   */
+  void Solve() override;
+
+  /**
+   * @brief Runs the tabu search for a bounded amount of time, starting from the
+   * best solution found so far
+   * @param seconds wall-clock budget of the call
+   * @return bool True, as another call can find a better solution
+   * @details The search restarts from the best solution at every call with an
+   * empty tabu list. The incumbent callback is called at the end of a call
+   * that improved the solution.
+   */
+  bool Step(const double seconds) override;
+
+ private:
+  TabuParameters params_;
+
+  /**
+   * @brief Runs the tabu search and stores the best solution found in the
+   * vehicles
+   * @return void
+   * @details Every iteration evaluates the moves of n_candidates_ random nodes
+   * that place the node next to one of its nearest neighbors (relocation,
+   * swap with the node on either side of the neighbor, 2-opt within a route
+   * and 2-opt* between routes) and applies the best one that is not tabu,
+   * even if it increases the cost. A tabu move is allowed if it leads to a
+   * solution better than the best one found (aspiration). A move that takes a
+   * node out of a route makes it tabu for the node to be moved back into the
+   * route; the attributes are stored in a hash table with the iteration at
+   * which they expire. The work per iteration does not depend on the number of
+   * nodes. Costs of the moves are calculated as Cost; distances are assumed
+   * to be symmetric.
+   */
+  template <typename Cost>
+  void Search();
+};
+
+#endif  // TS_HPP
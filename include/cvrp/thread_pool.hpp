@@ -0,0 +1,93 @@
+/**
+ * @file thread_pool.hpp
+ * @author vss2sn
+ * @brief Contains the ThreadPool class used to run independent tasks of the
+ * solvers concurrently
+ */
+
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief class ThreadPool
+ * @details Fixed set of worker threads that execute the iterations of a
+ * parallel loop. The calling thread takes part in the loop. If the pool is
+ * already running a loop (eg when called from one of its own tasks or from
+ * another thread at the same time), the loop is run on the calling thread.
+ */
+class ThreadPool {
+ public:
+  /**
+   * @brief Constructor
+   * @param n_threads total number of threads, including the calling thread
+   * @return no return value
+   * @details Starts n_threads - 1 worker threads
+   */
+  explicit ThreadPool(const size_t n_threads);
+
+  /**
+   * @brief Destructor
+   * @return no return value
+   * @details Stops and joins the worker threads
+   */
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  /**
+   * @brief Calls a function for every index in [0, n)
+   * @param n number of iterations
+   * @param f function to be called with each index
+   * @return void
+   * @details Blocks until all the iterations are complete. Iterations are
+   * handed out dynamically and may run in any order.
+   */
+  void ParallelFor(const int n, const std::function<void(int)> &f);
+
+  /**
+   * @brief Number of threads used by a parallel loop
+   * @return size_t number of threads, including the calling thread
+   */
+  size_t Size() const { return workers_.size() + 1; }
+
+ private:
+  std::vector<std::thread> workers_;
+  std::mutex run_mutex_;  // held while a loop is running
+  std::mutex mutex_;
+  std::condition_variable start_cv_;
+  std::condition_variable done_cv_;
+  const std::function<void(int)> *job_ = nullptr;
+  int n_ = 0;
+  std::atomic<int> next_{0};
+  size_t active_ = 0;
+  size_t generation_ = 0;
+  bool stop_ = false;
+
+  /**
+   * @brief Main loop of the worker threads
+   * @return void
+   */
+  void Work();
+
+  /**
+   * @brief Runs iterations of the current loop until none are left
+   * @return void
+   */
+  void RunTasks();
+};
+
+/**
+ * @brief Thread pool shared by the solvers
+ * @return ThreadPool& pool using all the hardware threads
+ */
+ThreadPool &DefaultThreadPool();
+
+#endif  // THREAD_POOL_HPP
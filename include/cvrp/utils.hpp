@@ -7,9 +7,18 @@
 #ifndef UTILS_HPP
 #define UTILS_HPP
 
+#include <functional>
+#include <memory>
 #include <string>
 #include <tuple>
+#include <utility>
 #include <vector>
+
+#include "cvrp/cost.hpp"
+
+class KdTree;
+class NeighborLists;
+
 /**
  * @brief struct node
  * @details Contains the x, y coordinates of the location of the node, its id,
@@ -18,7 +27,8 @@
  */
 struct Node {
  public:
-  float x_, y_, id_, demand_;
+  float x_, y_;
+  int id_, demand_;
   bool is_routed_;
 
   /**
@@ -101,20 +111,40 @@ struct Problem {
    * @param capacity maximum capacityof each vehicle
    * @param distribution distribution of nodes. Can be either clustered or
    * uniform.
+   * @param cost_type type used by the solvers for costs. Distances are rounded
+   * to the nearest integer for CostType::ROUNDED.
    * @return no return value
-   * @details Constructor for problem struct
+   * @details Constructor for problem struct. Also builds the neighbor lists
+   * of the nodes.
    */
   Problem(const std::vector<float> xc, 
           const std::vector<float> yc, 
           const std::vector<float> demandc,
           const int noc = 1000, const int nov = 50,
-          const int capacity = 800, std::string distribution = "uniform");
+          const int capacity = 800, std::string distribution = "uniform",
+          const CostType cost_type = CostType::DOUBLE);
+
+  /**
+   * @brief Renumbers the customers along a Hilbert curve
+   * @return void
+   * @details Optional preprocessing step. Customers that are close to each
+   * other get ids that are close to each other, so the rows of the distance
+   * matrix used by a route are close together in memory. The nodes, the
+   * distance matrix and the neighbor lists are permuted to match; the depot
+   * keeps id 0. Solutions created from the problem map the ids back when
+   * printing.
+   */
+  void RenumberCustomers();
 
   std::vector<Node> nodes_;
   std::vector<Vehicle> vehicles_;
-  std::vector<std::vector<double>> distanceMatrix_;
+  // Shared with the solutions created from the problem
+  std::shared_ptr<const std::vector<std::vector<double>>> distanceMatrix_;
+  std::shared_ptr<const NeighborLists> neighbors_;
   Node depot_;
   int capacity_;
+  CostType cost_type_;
+  std::shared_ptr<const std::vector<int>> original_ids_;  // null if unchanged
 };
 
 // Solution class should not call problems's constructor so not inheriting.
@@ -126,7 +156,8 @@ class Solution {
    * @param vehicles Vector of vehicles
    * @param distanceMatrix Matrix containing distance between each pair of nodes
    * @return no return type
-   * @details Constructor for solution struct
+   * @details Constructor for solution struct. Builds the neighbor lists of the
+   * nodes.
    */
   Solution(std::vector<Node> nodes, const std::vector<Vehicle> &vehicles,
            std::vector<std::vector<double>> distanceMatrix);
@@ -135,7 +166,8 @@ class Solution {
    * @brief Constructor
    * @param p Instance of Problem struct defining the problem parameters
    * @return no return type
-   * @details Constructor for solution struct
+   * @details Constructor for solution struct. Shares the distance matrix and
+   * the neighbor lists of the problem.
    */
   explicit Solution(const Problem &p);
 
@@ -189,6 +221,14 @@ class Solution {
    */
   bool CheckSolutionValid() const;
 
+  /**
+   * @brief Total length of the routes
+   * @return double cost of the solution
+   * @details Calculated from the distance matrix, so it does not rely on the
+   * costs stored in the vehicles being up to date
+   */
+  double TotalCost() const;
+
   //std::vector<double> Solution::GetDistances(const Node &n) const;
   
   /**
@@ -200,6 +240,34 @@ class Solution {
    */
   virtual void Solve() = 0;
 
+  /**
+   * @brief Function called with the solution whenever Step() finds a better
+   * one
+   */
+  using IncumbentCallback = std::function<void(const Solution &s)>;
+
+  /**
+   * @brief Runs the solver for a bounded amount of time, continuing from where
+   * the previous call stopped
+   * @param seconds wall-clock budget of the call
+   * @return bool True if calling Step() again can improve the solution
+   * @details Lets a caller run solvers in slices, eg to interleave several of
+   * them on a few threads. The solution in the vehicles is the best one found
+   * so far after every call, and the incumbent callback is called with it
+   * whenever it improves. Solvers that cannot be resumed run Solve() to
+   * completion on the first call, ignoring the budget, and return false.
+   */
+  virtual bool Step(const double seconds);
+
+  /**
+   * @brief Sets the function called whenever Step() finds a better solution
+   * @param callback function called with the solution
+   * @return void
+   */
+  void SetIncumbentCallback(IncumbentCallback callback) {
+    on_incumbent_ = std::move(callback);
+  }
+
   /**
    * @brief find closest node
    * @param v vehicle under consideration
@@ -210,6 +278,26 @@ class Solution {
    */
   std::tuple<bool, Node> find_closest(const Vehicle &v) const;
 
+  /**
+   * @brief find closest node using a spatial index
+   * @param v vehicle under consideration
+   * @param unrouted spatial index containing the nodes that have not been
+   * routed
+   * @return tuple containing bool as to whether a Node was found and the
+   * nearest node
+   * @details Finds the node nearest to the last node in the route of the
+   * vehicle under constideration whose demand can be met by the vehicle, in
+   * roughly O(log N). Routed nodes are expected to be erased from the index.
+   */
+  std::tuple<bool, Node> find_closest(const Vehicle &v,
+                                      const KdTree &unrouted) const;
+
+  /**
+   * @brief Builds a spatial index of the nodes that have not been routed
+   * @return KdTree spatial index of the unrouted nodes
+   */
+  KdTree UnroutedIndex() const;
+
   /**
    * @brief Prints the status of solution
    * @param option allows the option to print routes or vehicle statuses
@@ -224,14 +312,86 @@ class Solution {
   std::vector<Node> GetNodes() const { return nodes_; }
 
   std::vector<Vehicle> GetVehicles() const { return vehicles_; }
+
+  /**
+   * @brief Nearest neighbors of each node
+   * @return const NeighborLists& k nearest customers of every node
+   */
+  const NeighborLists &GetNeighbors() const { return *neighbors_; }
+
+  /**
+   * @brief Type used by the solvers for costs
+   * @return CostType type of the costs
+   */
+  CostType GetCostType() const { return cost_type_; }
+
+  /**
+   * @brief Sets whether Solve() prints the solution
+   * @param verbose False to run silently, eg when solving concurrently
+   * @return void
+   */
+  void SetVerbose(const bool verbose) { verbose_ = verbose; }
+
+  /**
+   * @brief Whether Solve() prints the solution
+   * @return bool True if the solution is printed
+   */
+  bool Verbose() const { return verbose_; }
+
+  /**
+   * @brief Id of a node in the input of the problem
+   * @param id id of the node used by the solution
+   * @return int id of the node before the customers were renumbered
+   */
+  int OriginalId(const int id) const {
+    return original_ids_ ? (*original_ids_)[id] : id;
+  }
+
+  /**
+   * @brief Node with the id it has in the input of the problem
+   * @param n node used by the solution
+   * @return Node copy of the node with its original id
+   */
+  Node OriginalNode(Node n) const {
+    n.id_ = OriginalId(n.id_);
+    return n;
+  }
+
+  /**
+   * @brief Route of a vehicle using the ids of the input of the problem
+   * @param v vehicle of the solution
+   * @return Vehicle copy of the vehicle visiting the original ids
+   */
+  Vehicle OriginalRoute(Vehicle v) const {
+    for (auto &n : v.nodes_) {
+      n = OriginalId(n);
+    }
+    return v;
+  }
 protected:
   std::vector<Node> nodes_;
   std::vector<Vehicle> vehicles_;
 
  protected:
-  std::vector<std::vector<double>> distanceMatrix_;
+  // Shared by the solutions of a problem, so copying a solution is O(n)
+  std::shared_ptr<const std::vector<std::vector<double>>> distanceMatrix_;
+  std::shared_ptr<const NeighborLists> neighbors_;
   Node depot_;
   int capacity_;
+  CostType cost_type_ = CostType::DOUBLE;
+  std::shared_ptr<const std::vector<int>> original_ids_;
+  bool verbose_ = true;
+  IncumbentCallback on_incumbent_;
+
+  /**
+   * @brief Calls the incumbent callback, if one is set, with this solution
+   * @return void
+   */
+  void ReportIncumbent() const {
+    if (on_incumbent_) {
+      on_incumbent_(*this);
+    }
+  }
 };
 
 #endif  // UTILS_HPP
@@ -11,7 +11,9 @@
 #include "cvrp/greedy.hpp"
 #include "cvrp/local_search_inter_intra.hpp"
 #include "cvrp/local_search_intra.hpp"
+#include "cvrp/portfolio.hpp"
 #include "cvrp/simulated_annealing.hpp"
+#include "cvrp/solution_cache.hpp"
 #include "cvrp/tabu_search.hpp"
 #include <random>
 #include <iostream>
@@ -89,7 +91,26 @@ std::vector<std::string> listOfFilesSubdir(std::string directory) {
 }
 
 
-int main(int /* argc */, char** /* argv[] */) {
+int main(int argc, char** argv) {
+  // --portfolio runs all the solvers concurrently instead of the GA alone.
+  // --cache DIR keeps the best solution of each instance in DIR and starts
+  // from it, or from the solutions of the most similar instances in DIR if it
+  // has not been solved before; --target COST skips instances whose cached
+  // solution costs at most COST.
+  bool portfolio = false;
+  std::string cache_directory;
+  double target_cost = 0;
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg = argv[i];
+    if (arg == "--portfolio") {
+      portfolio = true;
+    } else if (arg == "--cache" && i + 1 < argc) {
+      cache_directory = argv[++i];
+    } else if (arg == "--target" && i + 1 < argc) {
+      target_cost = std::stod(argv[++i]);
+    }
+  }
+  const SolutionCache cache(cache_directory);
   std::string directory = "/Users/sakshisingh/Desktop/vrp/cvrp/data/training"; 
   std::string subdir;
   
@@ -106,9 +127,34 @@ int main(int /* argc */, char** /* argv[] */) {
       std::cout << "\n______________INSTANCE "  << subdir << "(cust:" << noc << ", vehicle:"<<nov<< ", capacity:"<< capacity << ")______________";
       constexpr int n_chromosomes = 20;
       constexpr int generations = 20;
-      GASolution vrp_ga(p, n_chromosomes, generations);
-      vrp_ga.Solve();
-      vrp_ga.PrintSolution("route", dirEntry.path().parent_path().relative_path(), generations);
+      constexpr int n_similar = 3;
+      const auto cached =
+          cache_directory.empty() ? nullptr : cache.Lookup(p);
+      if (cached && cached->TotalCost() <= target_cost) {
+        std::cout << "\nCached solution meets the target, not solving\n";
+        cached->PrintSolution("route", dirEntry.path().parent_path().relative_path(), generations);
+        std::cout << '\n';
+        continue;
+      }
+      std::unique_ptr<Solution> vrp;
+      if (portfolio) {
+        vrp = cached ? std::make_unique<PortfolioSolution>(*cached)
+                     : std::make_unique<PortfolioSolution>(p);
+      } else if (cached) {
+        vrp = std::make_unique<GASolution>(*cached, n_chromosomes, generations);
+      } else {
+        auto vrp_ga =
+            std::make_unique<GASolution>(p, n_chromosomes, generations);
+        if (!cache_directory.empty()) {
+          vrp_ga->SeedPopulation(cache.Transfer(p, n_similar));
+        }
+        vrp = std::move(vrp_ga);
+      }
+      vrp->Solve();
+      vrp->PrintSolution("route", dirEntry.path().parent_path().relative_path(), generations);
+      if (!cache_directory.empty()) {
+        cache.Store(p, *vrp);
+      }
       std::cout << '\n';
     }
   }   
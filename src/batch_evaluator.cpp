@@ -0,0 +1,315 @@
+/**
+ * @file batch_evaluator.cpp
+ * @author vss2sn
+ * @brief Contains the BatchEvaluator class that calculates the cost and
+ * validity of many chromosomes at once
+ */
+
+#include "cvrp/batch_evaluator.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <type_traits>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define CVRP_AVX2_KERNEL
+#endif
+
+namespace {
+
+constexpr size_t batch_size = 8;
+constexpr int no_boundary = std::numeric_limits<int>::max();
+// Gathers index the flat matrix with signed 32 bit offsets
+constexpr size_t max_gather_elements =
+    static_cast<size_t>(std::numeric_limits<int32_t>::max());
+
+#ifdef CVRP_AVX2_KERNEL
+/**
+ * @brief struct Lanes
+ * @details State of the 8 chromosomes being evaluated together
+ */
+struct Lanes {
+ public:
+  __m256i prev_, load_, k_, excess_, next_b_;
+  __m256d cost_lo_, cost_hi_;  // double costs
+  __m256 cost_ps_;             // float costs
+  __m256i cost_epi32_;         // int32_t costs
+};
+
+/**
+ * @brief Adds distances to the costs of the lanes
+ * @param s state of the lanes
+ * @param d distance to be added to each lane
+ * @return void
+ */
+template <typename Cost>
+__attribute__((target("avx2"))) inline void AddCost(Lanes &s, const __m256 d) {
+  if constexpr (std::is_same_v<Cost, double>) {
+    s.cost_lo_ =
+        _mm256_add_pd(s.cost_lo_, _mm256_cvtps_pd(_mm256_castps256_ps128(d)));
+    s.cost_hi_ = _mm256_add_pd(s.cost_hi_,
+                               _mm256_cvtps_pd(_mm256_extractf128_ps(d, 1)));
+  } else if constexpr (std::is_same_v<Cost, float>) {
+    s.cost_ps_ = _mm256_add_ps(s.cost_ps_, d);
+  } else {
+    // Distances are integral, so the conversion is exact
+    s.cost_epi32_ = _mm256_add_epi32(s.cost_epi32_, _mm256_cvtps_epi32(d));
+  }
+}
+
+/**
+ * @brief Stores the costs of the lanes
+ * @param s state of the lanes
+ * @param costs array of 8 costs
+ * @return void
+ */
+template <typename Cost>
+__attribute__((target("avx2"))) inline void StoreCosts(const Lanes &s,
+                                                       Cost *costs) {
+  if constexpr (std::is_same_v<Cost, double>) {
+    _mm256_storeu_pd(costs, s.cost_lo_);
+    _mm256_storeu_pd(costs + 4, s.cost_hi_);
+  } else if constexpr (std::is_same_v<Cost, float>) {
+    _mm256_storeu_ps(costs, s.cost_ps_);
+  } else {
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(costs), s.cost_epi32_);
+  }
+}
+
+/**
+ * @brief Returns the selected lanes to the depot and moves them to their next
+ * route
+ * @param s state of the lanes
+ * @param mask lanes whose current route ends
+ * @param distances flat distance matrix
+ * @param n number of nodes
+ * @param capacity capacity of each vehicle
+ * @param iters interleaved iterator vectors
+ * @return void
+ */
+template <typename Cost>
+__attribute__((target("avx2"))) inline void CloseRoutes(
+    Lanes &s, const __m256i mask, const float *distances, const __m256i n,
+    const __m256i capacity, const int *iters) {
+  const __m256 d = _mm256_mask_i32gather_ps(
+      _mm256_setzero_ps(), distances, _mm256_mullo_epi32(s.prev_, n),
+      _mm256_castsi256_ps(mask), 4);
+  AddCost<Cost>(s, d);
+  s.excess_ = _mm256_add_epi32(
+      s.excess_,
+      _mm256_and_si256(mask, _mm256_max_epi32(_mm256_sub_epi32(s.load_, capacity),
+                                              _mm256_setzero_si256())));
+  s.load_ = _mm256_andnot_si256(mask, s.load_);
+  s.prev_ = _mm256_andnot_si256(mask, s.prev_);
+  s.k_ = _mm256_sub_epi32(s.k_, mask);
+  const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+  const __m256i index = _mm256_add_epi32(
+      _mm256_slli_epi32(_mm256_add_epi32(s.k_, _mm256_set1_epi32(1)), 3),
+      lanes);
+  s.next_b_ = _mm256_mask_i32gather_epi32(s.next_b_, iters, index, mask, 4);
+}
+#endif
+
+}  // namespace
+
+template <typename Gene, typename Cost>
+BatchEvaluator<Gene, Cost>::BatchEvaluator(
+    const std::vector<Node> &nodes,
+    const std::vector<std::vector<double>> &distanceMatrix, const int capacity)
+    : n_(nodes.size()),
+      capacity_(capacity),
+      gather_(nodes.size() * nodes.size() <= max_gather_elements),
+      distances_(nodes.size() * nodes.size()),
+      demands_(nodes.size()) {
+  for (size_t i = 0; i < nodes.size(); i++) {
+    for (size_t j = 0; j < nodes.size(); j++) {
+      distances_[i * n_ + j] = ToCost<Cost>(distanceMatrix[i][j]);
+    }
+    demands_[i] = nodes[i].demand_;
+  }
+}
+
+template <typename Gene, typename Cost>
+Evaluation<Cost> BatchEvaluator<Gene, Cost>::Evaluate(
+    const std::vector<Gene> &chromosome,
+    const std::vector<Gene> &iterators) const {
+  // Same order of operations as the vectorised version so that the results
+  // are identical
+  Evaluation<Cost> e;
+  const size_t n_routes = iterators.size() - 1;
+  const int n_genes = chromosome.size();
+  size_t prev = 0;  // 64 bit offsets into the flat matrix
+  int load = 0;
+  size_t k = 0;
+  int next_b = iterators[1];
+  for (int p = 0; p <= n_genes; p++) {
+    while (k < n_routes && (next_b <= p || p == n_genes)) {
+      e.cost_ += static_cast<Cost>(distances_[prev * n_]);
+      e.excess_ += std::max(0, load - capacity_);
+      load = 0;
+      prev = 0;
+      k++;
+      next_b = (k < n_routes) ? iterators[k + 1] : no_boundary;
+    }
+    if (p == n_genes) {
+      break;
+    }
+    const int node = chromosome[p];
+    e.cost_ += static_cast<Cost>(distances_[prev * n_ + node]);
+    load += demands_[node];
+    prev = node;
+  }
+  e.valid_ = e.excess_ == 0;
+  return e;
+}
+
+template <typename Gene, typename Cost>
+Evaluation<Cost> BatchEvaluator<Gene, Cost>::Evaluate(
+    const std::vector<Gene> &chromosome, const std::vector<Gene> &iterators,
+    std::vector<Cost> &route_costs, std::vector<int> &route_loads) const {
+  Evaluation<Cost> e;
+  const size_t n_routes = iterators.size() - 1;
+  route_costs.assign(n_routes, 0);
+  route_loads.assign(n_routes, 0);
+  const int n_genes = chromosome.size();
+  size_t prev = 0;  // 64 bit offsets into the flat matrix
+  size_t k = 0;
+  int next_b = iterators[1];
+  for (int p = 0; p <= n_genes; p++) {
+    while (k < n_routes && (next_b <= p || p == n_genes)) {
+      const auto d = static_cast<Cost>(distances_[prev * n_]);
+      e.cost_ += d;
+      route_costs[k] += d;
+      e.excess_ += std::max(0, route_loads[k] - capacity_);
+      prev = 0;
+      k++;
+      next_b = (k < n_routes) ? iterators[k + 1] : no_boundary;
+    }
+    if (p == n_genes) {
+      break;
+    }
+    const int node = chromosome[p];
+    const auto d = static_cast<Cost>(distances_[prev * n_ + node]);
+    e.cost_ += d;
+    route_costs[k] += d;
+    route_loads[k] += demands_[node];
+    prev = node;
+  }
+  e.valid_ = e.excess_ == 0;
+  return e;
+}
+
+template <typename Gene, typename Cost>
+void BatchEvaluator<Gene, Cost>::Evaluate(
+    const std::vector<std::vector<Gene>> &chromosomes,
+    const std::vector<std::vector<Gene>> &iterators,
+    std::vector<Evaluation<Cost>> &evaluations) const {
+  evaluations.resize(chromosomes.size());
+  size_t i = 0;
+#ifdef CVRP_AVX2_KERNEL
+  static const bool has_avx2 = __builtin_cpu_supports("avx2");
+  if (has_avx2 && gather_) {
+    for (; i + batch_size <= chromosomes.size(); i += batch_size) {
+      EvaluateAVX2(chromosomes, iterators, i, evaluations);
+    }
+  }
+#endif
+  for (; i < chromosomes.size(); i++) {
+    evaluations[i] = Evaluate(chromosomes[i], iterators[i]);
+  }
+}
+
+#ifdef CVRP_AVX2_KERNEL
+template <typename Gene, typename Cost>
+void BatchEvaluator<Gene, Cost>::EvaluateAVX2(
+    const std::vector<std::vector<Gene>> &chromosomes,
+    const std::vector<std::vector<Gene>> &iterators, const size_t first,
+    std::vector<Evaluation<Cost>> &evaluations) const {
+  const int n_genes = chromosomes[first].size();
+  alignas(32) int n_routes[batch_size];
+  int max_routes = 0;
+  for (size_t l = 0; l < batch_size; l++) {
+    n_routes[l] = iterators[first + l].size() - 1;
+    max_routes = std::max(max_routes, n_routes[l]);
+  }
+
+  // Interleave the batch so that lane l of position p is at p * 8 + l. Lanes
+  // with fewer routes are padded with rows that mark the end of the last
+  // route.
+  std::vector<int> genes(n_genes * batch_size);
+  std::vector<int> iters((max_routes + 2) * batch_size, no_boundary);
+  for (size_t l = 0; l < batch_size; l++) {
+    const auto &c = chromosomes[first + l];
+    const auto &it = iterators[first + l];
+    for (int p = 0; p < n_genes; p++) {
+      genes[p * batch_size + l] = c[p];
+    }
+    for (int k = 0; k <= n_routes[l]; k++) {
+      iters[k * batch_size + l] = it[k];
+    }
+  }
+
+  const __m256i ones = _mm256_set1_epi32(-1);
+  const __m256i n = _mm256_set1_epi32(static_cast<int>(n_));
+  const __m256i capacity = _mm256_set1_epi32(capacity_);
+  const __m256i routes =
+      _mm256_load_si256(reinterpret_cast<const __m256i *>(n_routes));
+  Lanes s;
+  s.prev_ = _mm256_setzero_si256();
+  s.load_ = _mm256_setzero_si256();
+  s.k_ = _mm256_setzero_si256();
+  s.excess_ = _mm256_setzero_si256();
+  s.next_b_ = _mm256_loadu_si256(
+      reinterpret_cast<const __m256i *>(iters.data() + batch_size));
+  s.cost_lo_ = _mm256_setzero_pd();
+  s.cost_hi_ = _mm256_setzero_pd();
+  s.cost_ps_ = _mm256_setzero_ps();
+  s.cost_epi32_ = _mm256_setzero_si256();
+
+  for (int p = 0; p < n_genes; p++) {
+    const __m256i position = _mm256_set1_epi32(p);
+    while (true) {
+      const __m256i mask =
+          _mm256_andnot_si256(_mm256_cmpgt_epi32(s.next_b_, position), ones);
+      if (_mm256_testz_si256(mask, mask)) {
+        break;
+      }
+      CloseRoutes<Cost>(s, mask, distances_.data(), n, capacity,
+                        iters.data());
+    }
+    const __m256i node = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i *>(genes.data() + p * batch_size));
+    AddCost<Cost>(s, _mm256_i32gather_ps(
+                   distances_.data(),
+                   _mm256_add_epi32(_mm256_mullo_epi32(s.prev_, n), node), 4));
+    s.load_ = _mm256_add_epi32(
+        s.load_, _mm256_i32gather_epi32(demands_.data(), node, 4));
+    s.prev_ = node;
+  }
+  while (true) {
+    const __m256i mask = _mm256_cmpgt_epi32(routes, s.k_);
+    if (_mm256_testz_si256(mask, mask)) {
+      break;
+    }
+    CloseRoutes<Cost>(s, mask, distances_.data(), n, capacity, iters.data());
+  }
+
+  Cost costs[batch_size];
+  alignas(32) int excess[batch_size];
+  StoreCosts(s, costs);
+  _mm256_store_si256(reinterpret_cast<__m256i *>(excess), s.excess_);
+  for (size_t l = 0; l < batch_size; l++) {
+    evaluations[first + l].cost_ = costs[l];
+    evaluations[first + l].excess_ = excess[l];
+    evaluations[first + l].valid_ = excess[l] == 0;
+  }
+}
+#endif
+
+template class BatchEvaluator<uint16_t, double>;
+template class BatchEvaluator<uint16_t, float>;
+template class BatchEvaluator<uint16_t, int32_t>;
+template class BatchEvaluator<int32_t, double>;
+template class BatchEvaluator<int32_t, float>;
+template class BatchEvaluator<int32_t, int32_t>;
@@ -0,0 +1,189 @@
+/**
+ * @file education.cpp
+ * @author vss2sn
+ * @brief Contains the local search used to educate (improve) the routes of a
+ * solution, as used by the memetic mode of the genetic algorithm
+ */
+
+#include "cvrp/education.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <utility>
+
+namespace {
+
+constexpr double margin_of_error = 0.00001;
+constexpr size_t max_segment_length = 3;
+
+/**
+ * @brief Applies the first improving 2-opt move found within a route
+ * @param v vehicle whose route is to be improved
+ * @param distanceMatrix Matrix containing distance between each pair of nodes
+ * @param neighbors Nearest neighbors of each node
+ * @return bool True if a move was applied
+ */
+bool TwoOpt(Vehicle &v, const std::vector<std::vector<double>> &distanceMatrix,
+            const NeighborLists &neighbors) {
+  auto &r = v.nodes_;
+  for (size_t i = 1; i + 1 < r.size(); i++) {
+    for (size_t j = i + 1; j + 1 < r.size(); j++) {
+      if (!neighbors.WithinRadius(r[i - 1], distanceMatrix[r[i - 1]][r[j]]) &&
+          !neighbors.WithinRadius(r[j + 1], distanceMatrix[r[i]][r[j + 1]])) {
+        continue;
+      }
+      const double delta =
+          distanceMatrix[r[i - 1]][r[j]] + distanceMatrix[r[i]][r[j + 1]] -
+          distanceMatrix[r[i - 1]][r[i]] - distanceMatrix[r[j]][r[j + 1]];
+      if (delta < -margin_of_error) {
+        std::reverse(std::next(r.begin(), i), std::next(r.begin(), j + 1));
+        v.CalculateCost(distanceMatrix);
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+/**
+ * @brief Applies the first improving Or-opt move found within a route
+ * @param v vehicle whose route is to be improved
+ * @param distanceMatrix Matrix containing distance between each pair of nodes
+ * @param neighbors Nearest neighbors of each node
+ * @return bool True if a move was applied
+ * @details Moves a segment of 1 to max_segment_length consecutive nodes to
+ * another position in the same route
+ */
+bool OrOpt(Vehicle &v, const std::vector<std::vector<double>> &distanceMatrix,
+           const NeighborLists &neighbors) {
+  auto &r = v.nodes_;
+  for (size_t len = 1; len <= max_segment_length; len++) {
+    for (size_t i = 1; i + len < r.size(); i++) {
+      const size_t last = i + len - 1;
+      const int prev = r[i - 1];
+      const int next = r[last + 1];
+      const double removal_gain = distanceMatrix[prev][r[i]] +
+                                  distanceMatrix[r[last]][next] -
+                                  distanceMatrix[prev][next];
+      for (size_t p = 0; p + 1 < r.size(); p++) {
+        if ((p + 1 >= i && p <= last) ||
+            (!neighbors.WithinRadius(r[i], distanceMatrix[r[p]][r[i]]) &&
+             !neighbors.WithinRadius(r[last],
+                                     distanceMatrix[r[last]][r[p + 1]]))) {
+          continue;
+        }
+        const double insertion_cost = distanceMatrix[r[p]][r[i]] +
+                                      distanceMatrix[r[last]][r[p + 1]] -
+                                      distanceMatrix[r[p]][r[p + 1]];
+        if (insertion_cost - removal_gain < -margin_of_error) {
+          const std::vector<int> segment(std::next(r.begin(), i),
+                                         std::next(r.begin(), last + 1));
+          r.erase(std::next(r.begin(), i), std::next(r.begin(), last + 1));
+          const size_t insert_at = (p > last) ? p + 1 - len : p + 1;
+          r.insert(std::next(r.begin(), insert_at), segment.begin(),
+                   segment.end());
+          v.CalculateCost(distanceMatrix);
+          return true;
+        }
+      }
+    }
+  }
+  return false;
+}
+
+/**
+ * @brief Applies the first improving relocate move found between two routes
+ * @param vehicles vehicles whose routes are to be improved
+ * @param nodes Vector of all nodes
+ * @param distanceMatrix Matrix containing distance between each pair of nodes
+ * @param neighbors Nearest neighbors of each node
+ * @return bool True if a move was applied
+ * @details Moves a single node from the route of one vehicle next to one of
+ * its neighbors in the route of another vehicle that has enough capacity left
+ */
+bool Relocate(std::vector<Vehicle> &vehicles, const std::vector<Node> &nodes,
+              const std::vector<std::vector<double>> &distanceMatrix,
+              const NeighborLists &neighbors) {
+  // Vehicle and position of every routed node
+  std::vector<std::pair<int, int>> where(nodes.size(), {-1, -1});
+  for (size_t k = 0; k < vehicles.size(); k++) {
+    for (size_t pos = 1; pos + 1 < vehicles[k].nodes_.size(); pos++) {
+      where[vehicles[k].nodes_[pos]] = {k, pos};
+    }
+  }
+  for (auto &v : vehicles) {
+    for (size_t cur = 1; cur + 1 < v.nodes_.size(); cur++) {
+      const int v_cur = v.nodes_[cur];
+      const int v_prev = v.nodes_[cur - 1];
+      const int v_next = v.nodes_[cur + 1];
+      const double removal_gain = distanceMatrix[v_prev][v_cur] +
+                                  distanceMatrix[v_cur][v_next] -
+                                  distanceMatrix[v_prev][v_next];
+      for (const int neighbor : neighbors.Of(v_cur)) {
+        const auto [k, pos] = where[neighbor];
+        if (k < 0 || &vehicles[k] == &v ||
+            vehicles[k].load_ - nodes[v_cur].demand_ < 0) {
+          continue;
+        }
+        auto &v2 = vehicles[k];
+        // Insert either before or after the neighbor
+        for (int rep = pos - 1; rep <= pos; rep++) {
+          const int v_rep = v2.nodes_[rep];
+          const int v_next_r = v2.nodes_[rep + 1];
+          const double insertion_cost = distanceMatrix[v_rep][v_cur] +
+                                        distanceMatrix[v_cur][v_next_r] -
+                                        distanceMatrix[v_rep][v_next_r];
+          if (insertion_cost - removal_gain < -margin_of_error) {
+            v.nodes_.erase(std::next(v.nodes_.begin(), cur));
+            v2.nodes_.insert(std::next(v2.nodes_.begin(), rep + 1), v_cur);
+            v.load_ += nodes[v_cur].demand_;
+            v2.load_ -= nodes[v_cur].demand_;
+            v.CalculateCost(distanceMatrix);
+            v2.CalculateCost(distanceMatrix);
+            return true;
+          }
+        }
+      }
+    }
+  }
+  return false;
+}
+
+}  // namespace
+
+int EducateRoutes(std::vector<Vehicle> &vehicles, const std::vector<Node> &nodes,
+                  const std::vector<std::vector<double>> &distanceMatrix,
+                  const NeighborLists &neighbors,
+                  const EducationParameters &params) {
+  const auto start = std::chrono::steady_clock::now();
+  const auto within_budget = [&](const int moves) {
+    if (params.move_budget_ > 0 && moves >= params.move_budget_) {
+      return false;
+    }
+    if (params.time_budget_ > 0) {
+      const std::chrono::duration<double> elapsed =
+          std::chrono::steady_clock::now() - start;
+      return elapsed.count() < params.time_budget_;
+    }
+    return true;
+  };
+
+  int moves = 0;
+  bool improved = true;
+  while (improved && within_budget(moves)) {
+    improved = false;
+    for (auto &v : vehicles) {
+      while (within_budget(moves) &&
+             (TwoOpt(v, distanceMatrix, neighbors) ||
+              OrOpt(v, distanceMatrix, neighbors))) {
+        improved = true;
+        moves++;
+      }
+    }
+    if (within_budget(moves) && Relocate(vehicles, nodes, distanceMatrix, neighbors)) {
+      improved = true;
+      moves++;
+    }
+  }
+  return moves;
+}
@@ -7,37 +7,332 @@
 #include "cvrp/genetic_algorithm.hpp"
 
 #include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <limits>
 #include <random>
 #include <set>
+#include <sstream>
+#include <type_traits>
+
+#include "cvrp/thread_pool.hpp"
 
 constexpr int total_percentage = 100;
 
+namespace {
+
+constexpr uint64_t checkpoint_magic = 0x314b434f4147;  // "GAOCK1"
+constexpr uint32_t checkpoint_version = 3;
+constexpr uint64_t max_checkpoint_chromosomes = 1 << 20;
+constexpr uint64_t fnv_offset_basis = 14695981039346656037ULL;
+constexpr uint64_t fnv_prime = 1099511628211ULL;
+
+/**
+ * @brief struct CheckpointHeader
+ * @details Start of a checkpoint, used to check that it was written for the
+ * same instance and by a kernel using the same types
+ */
+struct CheckpointHeader {
+ public:
+  uint64_t magic_ = 0;
+  uint32_t version_ = 0;
+  uint32_t gene_size_ = 0;
+  uint32_t cost_size_ = 0;
+  uint32_t cost_is_integral_ = 0;
+  uint64_t n_nodes_ = 0;
+  uint64_t n_vehicles_ = 0;
+  int64_t capacity_ = 0;
+  int64_t total_demand_ = 0;
+  uint64_t nodes_hash_ = 0;
+  int32_t n_chromosomes_ = 0;
+  int32_t generations_ = 0;
+};
+
+/**
+ * @brief Content hash of the nodes of an instance
+ * @param nodes Vector of all nodes
+ * @return uint64_t 64 bit FNV-1a hash of the coordinates and demands of the
+ * nodes, in the order of their ids
+ */
+uint64_t NodesHash(const std::vector<Node> &nodes) {
+  uint64_t hash = fnv_offset_basis;
+  const auto add = [&hash](const auto &value) {
+    unsigned char bytes[sizeof(value)];
+    std::memcpy(bytes, &value, sizeof(value));
+    for (const auto byte : bytes) {
+      hash ^= byte;
+      hash *= fnv_prime;
+    }
+  };
+  for (const auto &n : nodes) {
+    add(n.x_);
+    add(n.y_);
+    add(n.demand_);
+  }
+  return hash;
+}
+
+/**
+ * @brief Checks that a chromosome and its iterator vector describe a solution
+ * @param chromosome order in which the nodes are visited
+ * @param iterators points at which the chromosome is split into routes
+ * @param n_customers number of customers of the instance
+ * @return bool True if the chromosome is a permutation of the customers
+ * 1..n_customers, and the iterators are non-decreasing and start at 0 and end
+ * at n_customers
+ */
+template <typename T>
+bool IsSolution(const std::vector<T> &chromosome,
+                const std::vector<T> &iterators, const size_t n_customers) {
+  if (chromosome.size() != n_customers || iterators.size() < 2 ||
+      iterators.front() != 0 ||
+      static_cast<size_t>(iterators.back()) != n_customers ||
+      !std::is_sorted(iterators.begin(), iterators.end())) {
+    return false;
+  }
+  std::vector<char> visited(n_customers + 1, 0);
+  for (const auto gene : chromosome) {
+    if (gene < 1 || static_cast<size_t>(gene) > n_customers || visited[gene]) {
+      return false;
+    }
+    visited[gene] = 1;
+  }
+  return true;
+}
+
+/**
+ * @brief Header of a checkpoint of a kernel
+ * @param nodes Vector of all nodes
+ * @param n_vehicles size of the fleet
+ * @param capacity capacity of the vehicles
+ * @param n_chromosomes number of solutions
+ * @param generations number of generations of the run
+ * @return CheckpointHeader header
+ */
+template <typename Gene, typename Cost>
+CheckpointHeader MakeCheckpointHeader(const std::vector<Node> &nodes,
+                                      const size_t n_vehicles,
+                                      const int capacity,
+                                      const int n_chromosomes,
+                                      const int generations) {
+  CheckpointHeader header;
+  header.magic_ = checkpoint_magic;
+  header.version_ = checkpoint_version;
+  header.gene_size_ = sizeof(Gene);
+  header.cost_size_ = sizeof(Cost);
+  header.cost_is_integral_ = std::is_integral_v<Cost>;
+  header.n_nodes_ = nodes.size();
+  header.n_vehicles_ = n_vehicles;
+  header.capacity_ = capacity;
+  for (const auto &n : nodes) {
+    header.total_demand_ += n.demand_;
+  }
+  header.nodes_hash_ = NodesHash(nodes);
+  header.n_chromosomes_ = n_chromosomes;
+  header.generations_ = generations;
+  return header;
+}
+
+/**
+ * @brief Checks whether two checkpoint headers describe the same run
+ * @param a header
+ * @param b header
+ * @return bool True if all the fields match
+ */
+bool SameRun(const CheckpointHeader &a, const CheckpointHeader &b) {
+  return a.magic_ == b.magic_ && a.version_ == b.version_ &&
+         a.gene_size_ == b.gene_size_ && a.cost_size_ == b.cost_size_ &&
+         a.cost_is_integral_ == b.cost_is_integral_ &&
+         a.n_nodes_ == b.n_nodes_ && a.n_vehicles_ == b.n_vehicles_ &&
+         a.capacity_ == b.capacity_ && a.total_demand_ == b.total_demand_ &&
+         a.nodes_hash_ == b.nodes_hash_ &&
+         a.n_chromosomes_ == b.n_chromosomes_ &&
+         a.generations_ == b.generations_;
+}
+
+template <typename T>
+void Write(std::ostream &os, const T &value) {
+  static_assert(std::is_trivially_copyable_v<T>);
+  os.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+template <typename T>
+bool Read(std::istream &is, T &value) {
+  static_assert(std::is_trivially_copyable_v<T>);
+  return static_cast<bool>(
+      is.read(reinterpret_cast<char *>(&value), sizeof(T)));
+}
+
+template <typename T>
+void WriteVector(std::ostream &os, const std::vector<T> &v) {
+  Write(os, static_cast<uint64_t>(v.size()));
+  os.write(reinterpret_cast<const char *>(v.data()), v.size() * sizeof(T));
+}
+
+template <typename T>
+bool ReadVector(std::istream &is, std::vector<T> &v, const uint64_t max_size) {
+  uint64_t size = 0;
+  if (!Read(is, size) || size > max_size) {
+    return false;
+  }
+  v.resize(size);
+  return static_cast<bool>(
+      is.read(reinterpret_cast<char *>(v.data()), size * sizeof(T)));
+}
+
+/**
+ * @brief Writes a bool as a single byte
+ * @param os stream to be written
+ * @param value value to be written
+ * @return void
+ */
+void WriteBool(std::ostream &os, const bool value) {
+  Write(os, static_cast<uint8_t>(value));
+}
+
+/**
+ * @brief Reads a bool written by WriteBool()
+ * @param is stream to be read
+ * @param value value read
+ * @return bool True if a byte was read and it is 0 or 1
+ */
+bool ReadBool(std::istream &is, bool &value) {
+  uint8_t byte = 0;
+  if (!Read(is, byte) || byte > 1) {
+    return false;
+  }
+  value = byte == 1;
+  return true;
+}
+
+/**
+ * @brief Reads a number and checks its range
+ * @param is stream to be read
+ * @param value value read
+ * @param min smallest value accepted
+ * @param max largest value accepted
+ * @return bool True if the value was read and lies in [min, max]
+ * @details Also rejects NaN and, unless max is infinite, infinity
+ */
+template <typename T>
+bool ReadInRange(std::istream &is, T &value, const T min,
+                 const T max = std::numeric_limits<T>::max()) {
+  return Read(is, value) && value >= min && value <= max;
+}
+
+/**
+ * @brief Writes the education parameters field by field
+ * @param os stream to be written
+ * @param params parameters to be written
+ * @return void
+ */
+void WriteParameters(std::ostream &os, const EducationParameters &params) {
+  WriteBool(os, params.enabled_);
+  Write(os, params.move_budget_);
+  Write(os, params.time_budget_);
+}
+
+/**
+ * @brief Reads the education parameters written by WriteParameters()
+ * @param is stream to be read
+ * @param params parameters read
+ * @return bool True if every field was read and is in range
+ */
+bool ReadParameters(std::istream &is, EducationParameters &params) {
+  return ReadBool(is, params.enabled_) &&
+         ReadInRange(is, params.move_budget_, 0) &&
+         ReadInRange(is, params.time_budget_, 0.0);
+}
+
+/**
+ * @brief Writes the penalty parameters field by field
+ * @param os stream to be written
+ * @param params parameters to be written
+ * @return void
+ */
+void WriteParameters(std::ostream &os, const PenaltyParameters &params) {
+  WriteBool(os, params.enabled_);
+  Write(os, params.initial_penalty_);
+  Write(os, params.target_feasible_);
+  Write(os, params.adjustment_interval_);
+  Write(os, params.max_infeasible_share_);
+}
+
+/**
+ * @brief Reads the penalty parameters written by WriteParameters()
+ * @param is stream to be read
+ * @param params parameters read
+ * @return bool True if every field was read and is in range
+ */
+bool ReadParameters(std::istream &is, PenaltyParameters &params) {
+  return ReadBool(is, params.enabled_) &&
+         ReadInRange(is, params.initial_penalty_, 0.0) &&
+         ReadInRange(is, params.target_feasible_, 0.0, 1.0) &&
+         ReadInRange(is, params.adjustment_interval_, 0) &&
+         ReadInRange(is, params.max_infeasible_share_, 0.0, 1.0);
+}
+
+/**
+ * @brief Reads the header of a checkpoint
+ * @param path file containing the checkpoint
+ * @return CheckpointHeader header, with a magic_ of 0 if it could not be read
+ */
+CheckpointHeader ReadCheckpointHeader(const std::string &path) {
+  std::ifstream is(path, std::ios::binary);
+  CheckpointHeader header;
+  if (!Read(is, header)) {
+    return CheckpointHeader();
+  }
+  return header;
+}
+
+/**
+ * @brief Writes a checkpoint atomically
+ * @param kernel kernel whose state is written
+ * @param path file to be written
+ * @return bool True if the file was written
+ * @details Writes to a temporary file next to path and renames it to path, so
+ * path holds either the previous or the new checkpoint
+ */
+bool WriteCheckpoint(const GAKernelBase &kernel, const std::string &path) {
+  // Runs checkpointing to the same path use their own temporary files
+  std::ostringstream suffix;
+  suffix << std::hex << std::random_device()() << std::random_device()();
+  const std::string temp = path + "." + suffix.str() + ".tmp";
+  {
+    std::ofstream os(temp, std::ios::binary | std::ios::trunc);
+    kernel.Save(os);
+    os.flush();
+    if (!os) {
+      std::remove(temp.c_str());
+      return false;
+    }
+  }
+  std::error_code error;
+  std::filesystem::rename(temp, path, error);
+  if (error) {
+    std::remove(temp.c_str());
+    return false;
+  }
+  return true;
+}
+
+}  // namespace
+
 GASolution::GASolution(const Problem &p, const int n_chromosomes,
                        const int generations)
-    : Solution(p.nodes_, p.vehicles_, p.distanceMatrix_),
-      n_chromosomes_(n_chromosomes),
-      generations_(generations),
-      n_nucleotide_pairs_(nodes_.size() - 1),
-      costs_(std::vector<double>(n_chromosomes)),
-      n_vehicles_(vehicles_.size()) {
-  GenerateRandomSolutions();
-  for (int i = 0; i < n_chromosomes; i++) {
-    MakeValid(i);
-  }
-  GenerateGreedySolutions();
-  CalculateTotalCost();
-  best_ = std::min_element(costs_.begin(), costs_.end()) - costs_.begin();
+    : Solution(p), generations_(generations) {
+  CreateKernel(n_chromosomes);
 }
 
 GASolution::GASolution(const Solution &s, const int n_chromosomes,
                        const int generations)
-    : Solution(s),
-      n_chromosomes_(n_chromosomes),
-      generations_(generations),
-      n_nucleotide_pairs_(nodes_.size() - 1),
-      costs_(std::vector<double>(n_chromosomes)),
-      n_vehicles_(vehicles_.size()) {
+    : Solution(s), generations_(generations) {
   std::vector<int> temp_c;
   std::vector<int> temp_i{0};
   for (const auto &v : vehicles_) {
@@ -47,7 +342,7 @@ GASolution::GASolution(const Solution &s, const int n_chromosomes,
     temp_i.push_back(temp_c.size());
   }
 
-  // Reset vehicles_ to allow GenerateGreedySolutions() to run currectly
+  // Reset vehicles_ to allow GenerateInitialPopulation() to run currectly
   for (auto &v : vehicles_) {
     v.nodes_.clear();
     v.nodes_.push_back(0);
@@ -59,179 +354,428 @@ GASolution::GASolution(const Solution &s, const int n_chromosomes,
   }
   nodes_[0].is_routed_ = true;
 
-  GenerateRandomSolutions();
-  for (int i = 0; i < n_chromosomes; i++) {
-    MakeValid(i);
-  }
-  GenerateGreedySolutions();
+  CreateKernel(n_chromosomes);
   // Replacing the greedy solution (1st chromosome) with the solution given as
   // input
-  chromosomes_[0] = temp_c;
-  iterators_[0] = temp_i;
-  if (!checkValidity(0) ||
-      chromosomes_[0].size() != size_t(n_nucleotide_pairs_)) {
-    // Extra sanity check for size of solution
+  if (!kernel_->Seed(0, temp_c, temp_i)) {
     std::cout << "The input solution is invalid. Exiting." << '\n';
     exit(0);
   }
-  CalculateTotalCost();
-  best_ = std::min_element(costs_.begin(), costs_.end()) - costs_.begin();
+}
+
+GASolution::GASolution(const Problem &p, const std::string &checkpoint)
+    : Solution(p), generations_(ReadCheckpointHeader(checkpoint).generations_) {
+  CreateKernel(std::max(ReadCheckpointHeader(checkpoint).n_chromosomes_, 0),
+               false);
+  std::ifstream is(checkpoint, std::ios::binary);
+  if (!kernel_->Load(is)) {
+    std::cout << "The checkpoint could not be read or was written for another "
+                 "problem. Exiting."
+              << '\n';
+    exit(0);
+  }
 }
 
 GASolution::GASolution(const std::vector<Node> &nodes,
                        const std::vector<Vehicle> &vehicles,
                        const std::vector<std::vector<double>> &distanceMatrix,
                        const int n_chromosomes, const int generations)
-    : Solution(nodes, vehicles, distanceMatrix),
+    : Solution(nodes, vehicles, distanceMatrix), generations_(generations) {
+  CreateKernel(n_chromosomes);
+}
+
+GASolution::~GASolution() = default;
+
+void GASolution::CreateKernel(const int n_chromosomes,
+                              const bool generate_population) {
+  // Genes hold node ids and positions in the chromosome, both smaller than the
+  // number of nodes
+  if (nodes_.size() <= size_t(std::numeric_limits<uint16_t>::max()) + 1) {
+    CreateKernel<uint16_t>(n_chromosomes, generate_population);
+  } else {
+    CreateKernel<int32_t>(n_chromosomes, generate_population);
+  }
+}
+
+template <typename Gene>
+void GASolution::CreateKernel(const int n_chromosomes,
+                              const bool generate_population) {
+  switch (cost_type_) {
+    case CostType::FLOAT:
+      kernel_ = std::make_unique<GAKernel<Gene, float>>(
+          *this, n_chromosomes, generations_, generate_population);
+      break;
+    case CostType::ROUNDED:
+      kernel_ = std::make_unique<GAKernel<Gene, int32_t>>(
+          *this, n_chromosomes, generations_, generate_population);
+      break;
+    default:
+      kernel_ = std::make_unique<GAKernel<Gene, double>>(
+          *this, n_chromosomes, generations_, generate_population);
+      break;
+  }
+}
+
+void GASolution::Solve() { kernel_->Solve(); }
+
+bool GASolution::Step(const double seconds) {
+  return kernel_->Step(seconds, [this]() { ReportIncumbent(); });
+}
+
+int GASolution::SeedPopulation(
+    const std::vector<std::vector<std::vector<int>>> &solutions) {
+  const int n = kernel_->PopulationSize();
+  int seeded = 0;
+  for (const auto &routes : solutions) {
+    if (seeded >= n / 2) {
+      break;
+    }
+    std::vector<int> temp_c;
+    std::vector<int> temp_i{0};
+    for (const auto &route : routes) {
+      temp_c.insert(temp_c.end(), route.begin(), route.end());
+      temp_i.push_back(temp_c.size());
+    }
+    if (kernel_->Seed(n - 1 - seeded, temp_c, temp_i)) {
+      ++seeded;
+    }
+  }
+  return seeded;
+}
+
+bool GASolution::SaveCheckpoint(const std::string &path) const {
+  return WriteCheckpoint(*kernel_, path);
+}
+
+template <typename Gene, typename Cost>
+GAKernel<Gene, Cost>::GAKernel(GASolution &s, const int n_chromosomes,
+                               const int generations,
+                               const bool generate_population)
+    : solution_(s),
+      nodes_(s.nodes_),
+      vehicles_(s.vehicles_),
+      distanceMatrix_(*s.distanceMatrix_),
+      neighbors_(*s.neighbors_),
+      depot_(s.depot_),
+      capacity_(s.capacity_),
       n_chromosomes_(n_chromosomes),
       generations_(generations),
       n_nucleotide_pairs_(nodes_.size() - 1),
-      costs_(std::vector<double>(n_chromosomes)),
-      n_vehicles_(vehicles_.size()) {
-  GenerateRandomSolutions();
-  for (int i = 0; i < n_chromosomes; i++) {
-    MakeValid(i);
+      costs_(std::vector<Cost>(n_chromosomes)),
+      n_vehicles_(vehicles_.size()),
+      evaluator_(nodes_, distanceMatrix_, capacity_),
+      rng_(rand()) {
+  int total_demand = 0;
+  for (const auto &n : nodes_) {
+    total_demand += n.demand_;
+  }
+  min_routes_ = std::clamp((total_demand + capacity_ - 1) / capacity_, 1,
+                           static_cast<int>(n_vehicles_));
+  if (generate_population) {
+    GenerateInitialPopulation();
+    UpdateBest();
+  }
+}
+
+template <typename Gene, typename Cost>
+void GAKernel<Gene, Cost>::Save(std::ostream &os) const {
+  Write(os, MakeCheckpointHeader<Gene, Cost>(nodes_, n_vehicles_, capacity_,
+                                             n_chromosomes_, generations_));
+
+  Write(os, static_cast<uint64_t>(chromosomes_.size()));
+  for (size_t i = 0; i < chromosomes_.size(); ++i) {
+    WriteVector(os, chromosomes_[i]);
+    WriteVector(os, iterators_[i]);
+  }
+  WriteVector(os, costs_);
+  WriteVector(os, excess_);
+  Write(os, best_);
+  Write(os, generation_);
+  WriteParameters(os, education_);
+  WriteParameters(os, penalty_);
+  Write(os, time_budget_);
+  Write(os, penalty_weight_);
+  Write(os, penalty_cost_);
+  Write(os, n_children_);
+  Write(os, n_feasible_children_);
+  WriteVector(os, incumbent_.chromosome_);
+  WriteVector(os, incumbent_.iterators_);
+  Write(os, incumbent_.cost_);
+  WriteBool(os, incumbent_.found_);
+  std::ostringstream rng;
+  rng << rng_;
+  const std::string state = rng.str();
+  WriteVector(os, std::vector<char>(state.begin(), state.end()));
+}
+
+template <typename Gene, typename Cost>
+bool GAKernel<Gene, Cost>::Load(std::istream &is) {
+  CheckpointHeader header;
+  if (!Read(is, header) ||
+      !SameRun(header, MakeCheckpointHeader<Gene, Cost>(
+                           nodes_, n_vehicles_, capacity_, n_chromosomes_,
+                           generations_))) {
+    return false;
+  }
+
+  // The population keeps its size between generations
+  uint64_t n = 0;
+  if (!Read(is, n) || n != static_cast<uint64_t>(n_chromosomes_) ||
+      n > max_checkpoint_chromosomes) {
+    return false;
+  }
+  std::vector<std::vector<Gene>> chromosomes(n);
+  std::vector<std::vector<Gene>> iterators(n);
+  for (size_t i = 0; i < n; ++i) {
+    if (!ReadVector(is, chromosomes[i], n_nucleotide_pairs_) ||
+        !ReadVector(is, iterators[i], n_vehicles_ + 1) ||
+        !IsSolution(chromosomes[i], iterators[i], n_nucleotide_pairs_)) {
+      return false;
+    }
   }
-  GenerateGreedySolutions();
+  // Everything is read into locals first so that a rejected checkpoint
+  // leaves the kernel untouched
+  std::vector<Cost> costs;
+  std::vector<int> excess;
+  int best = 0;
+  int generation = 0;
+  EducationParameters education;
+  PenaltyParameters penalty;
+  double time_budget = 0;
+  double penalty_weight = 0;
+  Cost penalty_cost = 0;
+  int n_children = 0;
+  int n_feasible_children = 0;
+  Incumbent incumbent;
+  std::vector<char> rng;
+  if (!ReadVector(is, costs, n) || costs.size() != n ||
+      !ReadVector(is, excess, n) || excess.size() != n ||
+      !ReadInRange(is, best, 0, static_cast<int>(n) - 1) ||
+      !ReadInRange(is, generation, 0, generations_) ||
+      !ReadParameters(is, education) || !ReadParameters(is, penalty) ||
+      !ReadInRange(is, time_budget, 0.0) ||
+      !ReadInRange(is, penalty_weight, 0.0) ||
+      !ReadInRange(is, penalty_cost, Cost(0)) ||
+      !ReadInRange(is, n_children, 0) ||
+      !ReadInRange(is, n_feasible_children, 0, n_children) ||
+      !ReadVector(is, incumbent.chromosome_, n_nucleotide_pairs_) ||
+      !ReadVector(is, incumbent.iterators_, n_vehicles_ + 1) ||
+      !Read(is, incumbent.cost_) || !ReadBool(is, incumbent.found_) ||
+      !ReadVector(is, rng, std::numeric_limits<uint16_t>::max())) {
+    return false;
+  }
+  std::default_random_engine engine;
+  std::istringstream rng_state(std::string(rng.begin(), rng.end()));
+  if (!(rng_state >> engine)) {
+    return false;
+  }
+  if (incumbent.found_) {
+    std::vector<Cost> route_costs;
+    std::vector<int> route_loads;
+    if (!IsSolution(incumbent.chromosome_, incumbent.iterators_,
+                    n_nucleotide_pairs_)) {
+      return false;
+    }
+    const auto e = evaluator_.Evaluate(incumbent.chromosome_,
+                                       incumbent.iterators_, route_costs,
+                                       route_loads);
+    if (!e.valid_) {
+      return false;
+    }
+    incumbent.cost_ = e.cost_;
+  } else {
+    incumbent = Incumbent();
+  }
+  best_ = best;
+  generation_ = generation;
+  education_ = education;
+  penalty_ = penalty;
+  time_budget_ = time_budget;
+  penalty_weight_ = penalty_weight;
+  penalty_cost_ = penalty_cost;
+  n_children_ = n_children;
+  n_feasible_children_ = n_feasible_children;
+  rng_ = engine;
+  // The stored costs are not trusted; they are recalculated from the routes
+  chromosomes_ = std::move(chromosomes);
+  iterators_ = std::move(iterators);
+  costs_.assign(n, 0);
+  excess_.assign(n, 0);
   CalculateTotalCost();
-  best_ = std::min_element(costs_.begin(), costs_.end()) - costs_.begin();
+  incumbent_ = std::move(incumbent);
+  routes_.assign(n, {});
+  reported_cost_ = std::numeric_limits<Cost>::max();
+  for (auto &node : nodes_) {
+    node.is_routed_ = true;
+  }
+  return true;
+}
+
+template <typename Gene, typename Cost>
+bool GAKernel<Gene, Cost>::Seed(const int i, const std::vector<int> &chromosome,
+                          const std::vector<int> &iterators) {
+  // The input may come from outside (eg a cache file); every customer has to
+  // be visited exactly once
+  if (!IsSolution(chromosome, iterators, n_nucleotide_pairs_)) {
+    return false;
+  }
+  // Empty routes are not stored
+  std::vector<Gene> compact(iterators.begin(), iterators.end());
+  compact.erase(std::unique(compact.begin(), compact.end()), compact.end());
+  if (compact.size() > n_vehicles_ + 1) {
+    return false;
+  }
+  const auto temp_c = chromosomes_[i];
+  const auto temp_i = iterators_[i];
+  const int temp_x = excess_[i];
+  chromosomes_[i].assign(chromosome.begin(), chromosome.end());
+  iterators_[i] = std::move(compact);
+  const auto e = Evaluate(i);
+  if (!e.valid_) {
+    chromosomes_[i] = temp_c;
+    iterators_[i] = temp_i;
+    excess_[i] = temp_x;
+    Invalidate(i);
+    return false;
+  }
+  costs_[i] = Fitness(e);
+  UpdateBest();
+  return true;
 }
 
-std::vector<int> GASolution::GenerateRandomSolution() const {
-  std::vector<int> temp(n_nucleotide_pairs_);
+template <typename Gene, typename Cost>
+std::vector<Gene> GAKernel<Gene, Cost>::GenerateRandomSolution() const {
+  std::default_random_engine rng(rng_());
+  return GenerateRandomSolution(rng);
+}
+
+template <typename Gene, typename Cost>
+std::vector<Gene> GAKernel<Gene, Cost>::GenerateRandomSolution(
+    std::default_random_engine &rng) const {
+  std::vector<Gene> temp(n_nucleotide_pairs_);
   for (size_t i = 0; i < n_nucleotide_pairs_; ++i) {
     temp[i] = i + 1;
   }
-  unsigned seed =
-      rand();  // std::chrono::system_clock::now().time_since_epoch().count();
-  std::shuffle(temp.begin(), temp.end(), std::default_random_engine(seed));
+  std::shuffle(temp.begin(), temp.end(), rng);
   return temp;
 }
 
-std::vector<int> GASolution::GenerateRandomIterSolution() const {
-  std::vector<int> temp(n_vehicles_ + 1);
-  std::unordered_set<int> added;
-  temp[0] = 0;
-  added.insert(0);
-  for (size_t i = 1; i < n_vehicles_; ++i) {
-    size_t n = rand() % n_nucleotide_pairs_;
-    if (added.find(n) != added.end()) {
-      n = n_nucleotide_pairs_;
-    }
-    temp[i] = n;
+template <typename Gene, typename Cost>
+std::vector<Gene> GAKernel<Gene, Cost>::GenerateRandomIterSolution() const {
+  std::default_random_engine rng(rng_());
+  return GenerateRandomIterSolution(rng);
+}
+
+template <typename Gene, typename Cost>
+std::vector<Gene> GAKernel<Gene, Cost>::GenerateRandomIterSolution(
+    std::default_random_engine &rng) const {
+  // Only the minimum number of vehicles is used to begin with; MakeValid()
+  // adds routes as they are required
+  std::vector<Gene> temp{0};
+  for (int i = 1; i < min_routes_; ++i) {
+    temp.push_back(rng() % n_nucleotide_pairs_);
   }
-  temp[n_vehicles_] = n_nucleotide_pairs_;
+  temp.push_back(n_nucleotide_pairs_);
   std::sort(temp.begin(), temp.end());
+  temp.erase(std::unique(temp.begin(), temp.end()), temp.end());
   return temp;
 }
 
-void GASolution::GenerateRandomSolutions() {
-  std::vector<int> temp(n_nucleotide_pairs_);
-  for (int i = 0; i < n_nucleotide_pairs_; ++i) {
-    temp[i] = i + 1;
+template <typename Gene, typename Cost>
+void GAKernel<Gene, Cost>::GenerateInitialPopulation() {
+  chromosomes_.assign(n_chromosomes_, {});
+  iterators_.assign(n_chromosomes_, {});
+  routes_.assign(n_chromosomes_, {});
+  excess_.assign(n_chromosomes_, 0);
+  constexpr double percentage_of_chromosome = 0.2;
+  const int n_greedy = std::max(
+      1, static_cast<int>(std::ceil(percentage_of_chromosome * n_chromosomes_)));
+
+  // Seeds are drawn up front so that the population does not depend on the
+  // order in which the tasks are run
+  std::vector<unsigned> seeds(n_chromosomes_);
+  for (auto &seed : seeds) {
+    seed = rng_();
   }
-  for (int i = 0; i < n_chromosomes_; i++) {
-    chromosomes_.push_back(temp);
-  }
-  for (int i = 0; i < n_chromosomes_; ++i) {
-    unsigned seed =
-        rand();  // std::chrono::system_clock::now().time_since_epoch().count();
-    std::shuffle(chromosomes_[i].begin(), chromosomes_[i].end(),
-                 std::default_random_engine(seed));
-  }
-  for (int j = 0; j < n_chromosomes_; j++) {
-    std::vector<int> temp_i(n_vehicles_ + 1, 0);
-    std::unordered_set<int> added;
-    for (int i = 1; i < n_vehicles_; ++i) {
-      size_t n = rand() % n_nucleotide_pairs_;
-      if (added.find(n) != added.end()) {
-        n = n_nucleotide_pairs_;
-      }
-      temp_i[i] = n;
+  const auto unrouted = solution_.UnroutedIndex();
+  DefaultThreadPool().ParallelFor(n_chromosomes_, [&](const int i) {
+    std::default_random_engine rng(seeds[i]);
+    if (i < n_greedy) {
+      // The first greedy solution starts at the depot, the others at a
+      // random node
+      const int first = (i == 0) ? 0 : rng() % n_nucleotide_pairs_ + 1;
+      GenerateGreedySolution(i, first, unrouted);
+    } else {
+      chromosomes_[i] = GenerateRandomSolution(rng);
+      iterators_[i] = GenerateRandomIterSolution(rng);
     }
-    temp_i[n_vehicles_] = n_nucleotide_pairs_;
-    std::sort(temp_i.begin(), temp_i.end());
-    iterators_.push_back(temp_i);
+    MakeValid(i);
+    costs_[i] = CalculateCost(i);
+  });
+  for (auto &n : nodes_) {
+    n.is_routed_ = true;
   }
 }
 
-void GASolution::GenerateGreedySolutions() {
-  std::vector<int> gs;
-  auto vehicles_2 = vehicles_;
-  std::vector<int> iter;
-  iter.push_back(0);
-  for (auto &v : vehicles_2) {
+template <typename Gene, typename Cost>
+void GAKernel<Gene, Cost>::GenerateGreedySolution(const int i, const int first,
+                                        KdTree unrouted) {
+  std::vector<Gene> gs;
+  gs.reserve(n_nucleotide_pairs_);
+  std::vector<Gene> iter{0};
+  int next = first;
+  for (const auto &vehicle : vehicles_) {
+    if (gs.size() == n_nucleotide_pairs_) {
+      break;
+    }
+    Vehicle v = vehicle;
     while (true) {
-      const auto [found, closest_node] = find_closest(v);
+      Node closest_node;
+      bool found = false;
+      if (next != 0) {
+        closest_node = nodes_[next];
+        found = true;
+        next = 0;
+      } else {
+        std::tie(found, closest_node) = solution_.find_closest(v, unrouted);
+      }
       if (found && v.load_ - closest_node.demand_ >= 0) {
         v.load_ -= closest_node.demand_;
-        v.cost_ += distanceMatrix_[v.nodes_.back()][closest_node.id_];
         v.nodes_.push_back(closest_node.id_);
         gs.push_back(closest_node.id_);
-        nodes_[closest_node.id_].is_routed_ = true;
+        unrouted.Erase(closest_node.id_);
       } else {
-        iter.push_back(iter.back() + v.nodes_.size() - 1);
-        v.cost_ += distanceMatrix_[v.nodes_.back()][depot_.id_];
-        v.nodes_.push_back(depot_.id_);
+        if (v.nodes_.size() > 1) {
+          iter.push_back(iter.back() + v.nodes_.size() - 1);
+        }
         break;
       }
     }
   }
-  if (gs.size() != size_t(n_nucleotide_pairs_)) {
-    std::cout << "1. Initial solution does not contain all the nodes_. Exiting\n";
-    exit(0);
-  }
-  chromosomes_[0] = gs;
-  iterators_[0] = iter;
-  costs_[0] = CalculateCost(0);
-  constexpr double percentage_of_chromosome = 0.2;
-  for (int j = 1; j < percentage_of_chromosome * n_chromosomes_; ++j) {
-    gs.clear();
-    iter.clear();
-    vehicles_2 = vehicles_;
-    iter.push_back(0);
-    for (auto &n : nodes_) {
-      n.is_routed_ = false;
-    }
-    nodes_[depot_.id_].is_routed_ = true;
-    int count = 0;
-    for (auto &v : vehicles_2) {
-      while (true) {
-        Node closest_node;
-        bool found = false;
-        if (count == 0) {
-          size_t i = rand() % (nodes_.size() - 1) + 1;
-          closest_node = nodes_[i];
-          count++;
-        } else {
-          std::tie(found, closest_node) = find_closest(v);
-        }
-        if (found && v.load_ - closest_node.demand_ >= 0) {
-          v.load_ -= closest_node.demand_;
-          v.cost_ += distanceMatrix_[v.nodes_.back()][closest_node.id_];
-          v.nodes_.push_back(closest_node.id_);
-          gs.push_back(closest_node.id_);
-          nodes_[closest_node.id_].is_routed_ = true;
-        } else {
-          iter.push_back(iter.back() + v.nodes_.size() - 1);
-          v.cost_ += distanceMatrix_[v.nodes_.back()][depot_.id_];
-          v.nodes_.push_back(depot_.id_);
-          break;
-        }
+  // The vehicles could not carry every node: the rest are appended to a last
+  // route and left to MakeValid()
+  if (gs.size() < n_nucleotide_pairs_) {
+    std::vector<char> routed(n_nucleotide_pairs_ + 1, 0);
+    for (const auto id : gs) {
+      routed[id] = 1;
+    }
+    for (size_t id = 1; id <= n_nucleotide_pairs_; id++) {
+      if (!routed[id]) {
+        gs.push_back(id);
       }
     }
-    chromosomes_[j] = gs;
-     if (gs.size() != size_t(n_nucleotide_pairs_)) {
-      std::cout << "\nInitial solutions do not contain all the nodes_. Exiting\n";
-      exit(0);
+    if (iter.size() <= n_vehicles_) {
+      iter.push_back(n_nucleotide_pairs_);
+    } else {
+      iter.back() = n_nucleotide_pairs_;
     }
-    iterators_[j] = iter;
-    MakeValid(j);
-    costs_[j] = CalculateCost(j);
   }
+  chromosomes_[i] = std::move(gs);
+  iterators_[i] = std::move(iter);
 }
 
-void GASolution::RemoveSimilarSolutions() {
+template <typename Gene, typename Cost>
+void GAKernel<Gene, Cost>::RemoveSimilarSolutions() {
   std::set<int> to_delete;
   constexpr double weight_95 = 0.95;
   constexpr double weight_105 = 1.05;
@@ -246,11 +790,11 @@ void GASolution::RemoveSimilarSolutions() {
           count++;
         }
       }
+      const auto c_i = static_cast<double>(costs_[i]);
+      const auto c_j = static_cast<double>(costs_[j]);
       if (count > weight_95 * n_nucleotide_pairs_ &&
-          ((costs_[i] > weight_95 * costs_[j] &&
-            costs_[i] < weight_105 * costs_[j]) ||
-           (costs_[j] > weight_95 * costs_[i] &&
-            costs_[j] < weight_105 * costs_[i]))) {
+          ((c_i > weight_95 * c_j && c_i < weight_105 * c_j) ||
+           (c_j > weight_95 * c_i && c_j < weight_105 * c_i))) {
         if (costs_[i] > costs_[j]) {
           to_delete.insert(i);
         } else {
@@ -261,7 +805,7 @@ void GASolution::RemoveSimilarSolutions() {
   }
   for (const auto i : to_delete) {
     constexpr int min_percentage = 15;
-    if (rand() % total_percentage > min_percentage) {
+    if (rng_() % total_percentage > min_percentage) {
       chromosomes_[i] = GenerateRandomSolution();
       iterators_[i] = GenerateRandomIterSolution();
       MakeValid(i);
@@ -270,29 +814,184 @@ void GASolution::RemoveSimilarSolutions() {
   }
 }
 
-double GASolution::CalculateCost(const int i) const {
-  double cost = 0;
-  for (size_t k = 0; k < iterators_[0].size() - 1; k++) {
-    if (iterators_[i][k] == n_nucleotide_pairs_) {
-      break;
+template <typename Gene, typename Cost>
+Evaluation<Cost> GAKernel<Gene, Cost>::Evaluate(const int i) {
+  auto &r = routes_[i];
+  const auto e =
+      evaluator_.Evaluate(chromosomes_[i], iterators_[i], r.costs_, r.loads_);
+  r.longest_.clear();
+  for (size_t k = 0; k < r.costs_.size(); k++) {
+    r.longest_.emplace_back(r.costs_[k], k);
+  }
+  std::make_heap(r.longest_.begin(), r.longest_.end());
+  r.valid_ = true;
+  excess_[i] = e.excess_;
+  return e;
+}
+
+template <typename Gene, typename Cost>
+typename GAKernel<Gene, Cost>::Routes &GAKernel<Gene, Cost>::CachedRoutes(
+    const int i) {
+  if (!routes_[i].valid_) {
+    Evaluate(i);
+  }
+  return routes_[i];
+}
+
+template <typename Gene, typename Cost>
+void GAKernel<Gene, Cost>::SetRouteCost(Routes &r, const int k,
+                                        const Cost cost) {
+  r.costs_[k] = cost;
+  if (r.longest_.size() > 2 * r.costs_.size()) {
+    // Drop the stale entries
+    r.longest_.clear();
+    for (size_t l = 0; l < r.costs_.size(); l++) {
+      r.longest_.emplace_back(r.costs_[l], l);
+    }
+    std::make_heap(r.longest_.begin(), r.longest_.end());
+  } else {
+    r.longest_.emplace_back(cost, k);
+    std::push_heap(r.longest_.begin(), r.longest_.end());
+  }
+}
+
+template <typename Gene, typename Cost>
+int GAKernel<Gene, Cost>::LongestRoute(const int i) {
+  auto &r = CachedRoutes(i);
+  while (r.longest_.front().first != r.costs_[r.longest_.front().second]) {
+    std::pop_heap(r.longest_.begin(), r.longest_.end());
+    r.longest_.pop_back();
+  }
+  return r.longest_.front().second;
+}
+
+template <typename Gene, typename Cost>
+Cost GAKernel<Gene, Cost>::CalculateCost(const int i) {
+  return Fitness(Evaluate(i));
+}
+
+template <typename Gene, typename Cost>
+void GAKernel<Gene, Cost>::CalculateTotalCost() {
+  std::vector<Evaluation<Cost>> evaluations;
+  evaluator_.Evaluate(chromosomes_, iterators_, evaluations);
+  for (int i = 0; i < n_chromosomes_; i++) {
+    costs_[i] = Fitness(evaluations[i]);
+    excess_[i] = evaluations[i].excess_;
+  }
+}
+
+template <typename Gene, typename Cost>
+void GAKernel<Gene, Cost>::SetPenalty(const PenaltyParameters &params) {
+  penalty_ = params;
+  n_children_ = 0;
+  n_feasible_children_ = 0;
+  if (!penalty_.enabled_) {
+    SetPenaltyWeight(0);
+    return;
+  }
+  double weight = penalty_.initial_penalty_;
+  if (weight <= 0) {
+    // Cost of the longest edge per unit of the largest demand
+    double max_distance = 0;
+    int max_demand = 1;
+    for (size_t i = 0; i < nodes_.size(); i++) {
+      max_demand = std::max(max_demand, nodes_[i].demand_);
+      for (size_t j = 0; j < nodes_.size(); j++) {
+        max_distance = std::max(max_distance, distanceMatrix_[i][j]);
+      }
     }
-    int j = iterators_[i][k];
-    if (j < iterators_[i][k + 1]) {
-      cost += distanceMatrix_[0][chromosomes_[i][j]];
+    weight = max_distance / max_demand;
+  }
+  SetPenaltyWeight(weight);
+}
+
+template <typename Gene, typename Cost>
+void GAKernel<Gene, Cost>::SetPenaltyWeight(const double weight) {
+  constexpr double min_penalty = 0.1;
+  constexpr double max_penalty = 100000;
+  penalty_weight_ =
+      (weight > 0) ? std::clamp(weight, min_penalty, max_penalty) : 0;
+  penalty_cost_ = ToCost<Cost>(penalty_weight_);
+  if constexpr (std::is_integral_v<Cost>) {
+    if (penalty_weight_ > 0) {
+      penalty_cost_ = std::max(penalty_cost_, Cost(1));
     }
-    while (j + 1 < iterators_[i][k + 1]) {
-      cost += distanceMatrix_[chromosomes_[i][j]][chromosomes_[i][j + 1]];
-      j++;
+  }
+  CalculateTotalCost();
+  UpdateBest();
+}
+
+template <typename Gene, typename Cost>
+void GAKernel<Gene, Cost>::AdjustPenalty() {
+  if (n_children_ == 0) {
+    return;
+  }
+  constexpr double tolerance = 0.05;
+  constexpr double increase = 1.2;
+  constexpr double decrease = 0.85;
+  const double feasible = static_cast<double>(n_feasible_children_) / n_children_;
+  n_children_ = 0;
+  n_feasible_children_ = 0;
+  if (feasible < penalty_.target_feasible_ - tolerance) {
+    SetPenaltyWeight(penalty_weight_ * increase);
+  } else if (feasible > penalty_.target_feasible_ + tolerance) {
+    SetPenaltyWeight(penalty_weight_ * decrease);
+  }
+}
+
+template <typename Gene, typename Cost>
+void GAKernel<Gene, Cost>::UpdateBest() {
+  best_ = std::min_element(costs_.begin(), costs_.end()) - costs_.begin();
+  if (!penalty_.enabled_) {
+    return;
+  }
+  int best_feasible = -1;
+  for (size_t i = 0; i < costs_.size(); i++) {
+    if (excess_[i] == 0 &&
+        (best_feasible < 0 || costs_[i] < costs_[best_feasible])) {
+      best_feasible = i;
     }
-    cost += distanceMatrix_[chromosomes_[i][j]][0];
   }
-  return cost;
+  if (best_feasible >= 0 &&
+      (!incumbent_.found_ || costs_[best_feasible] < incumbent_.cost_)) {
+    incumbent_.chromosome_ = chromosomes_[best_feasible];
+    incumbent_.iterators_ = iterators_[best_feasible];
+    incumbent_.cost_ = costs_[best_feasible];
+    incumbent_.found_ = true;
+  }
 }
 
-void GASolution::CalculateTotalCost() {
-  for (int i = 0; i < n_chromosomes_; i++) {
-    costs_[i] = CalculateCost(i);
+template <typename Gene, typename Cost>
+void GAKernel<Gene, Cost>::EraseChromosome(const int i) {
+  costs_.erase(costs_.begin() + i);
+  excess_.erase(excess_.begin() + i);
+  chromosomes_.erase(chromosomes_.begin() + i);
+  iterators_.erase(iterators_.begin() + i);
+  routes_.erase(routes_.begin() + i);
+}
+
+template <typename Gene, typename Cost>
+void GAKernel<Gene, Cost>::SubpopulationSelection() {
+  const int child = costs_.size() - 1;
+  int n_infeasible = 0;
+  for (int i = 0; i < child; i++) {
+    if (excess_[i] > 0) {
+      n_infeasible++;
+    }
   }
+  const int max_infeasible =
+      static_cast<int>(penalty_.max_infeasible_share_ * n_chromosomes_);
+  // An infeasible child takes the place of a feasible solution while the
+  // infeasible subpopulation is below its share
+  const bool feasible = excess_[child] == 0 || n_infeasible < max_infeasible;
+  int worst = -1;
+  for (int i = 0; i <= child; i++) {
+    if ((excess_[i] == 0) == feasible &&
+        (worst < 0 || costs_[i] > costs_[worst])) {
+      worst = i;
+    }
+  }
+  EraseChromosome(worst < 0 ? child : worst);
 }
 
 constexpr int p_mutate = 50;
@@ -300,56 +999,75 @@ constexpr int p_random_swap = 50;
 constexpr int p_mutate_within_gene = 50;
 constexpr int p_insert_iter_dist = 70;
 
-void GASolution::Solve() {
-  int generation = 0;
-  while (generation < generations_) {
+template <typename Gene, typename Cost>
+void GAKernel<Gene, Cost>::Solve() {
+  Step(time_budget_, nullptr);
+  GenerateBestSolution();
+  if (solution_.Verbose()) {
+    std::cout << "\n";
+  }
+}
+
+template <typename Gene, typename Cost>
+bool GAKernel<Gene, Cost>::Step(const double seconds,
+                                const std::function<void()>& on_improvement) {
+  const auto start = std::chrono::steady_clock::now();
+  const auto within_budget = [&]() {
+    const std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    return seconds <= 0 || elapsed.count() < seconds;
+  };
+  // Cost of the solution that would be returned, if it is feasible
+  const auto best_cost = [&]() {
+    UpdateBest();
+    if (!penalty_.enabled_) {
+      return costs_[best_];
+    }
+    return incumbent_.found_ ? incumbent_.cost_
+                             : std::numeric_limits<Cost>::max();
+  };
+  const auto report = [&]() {
+    if (on_improvement && best_cost() < reported_cost_) {
+      reported_cost_ = best_cost();
+      GenerateBestSolution();
+      on_improvement();
+    }
+  };
+  report();
+  while (generation_ < generations_ && within_budget()) {
     //std::cout << "Generation: " << generation << "  Best Solution: " << costs_[best_] << '\n';
     /* for(int i=0;i<chromosomes_.size();i++){
       if(!checkValidity(i)) std::cout << "Invalid" << '\n';
     } */
-    best_ = std::min_element(costs_.begin(), costs_.end()) - costs_.begin();
-    if (rand() % 2 == 0) {
+    UpdateBest();
+    if (rng_() % 2 == 0) {
       HGreXCrossover();
-      best_ = std::min_element(costs_.begin(), costs_.end()) - costs_.begin();
-    }
-    if (rand() % 2 == 0) {
-      int n = rand() % n_chromosomes_;
-      auto temp_i = iterators_[n];
-      MutateIterLeft(n, rand() % n_vehicles_);
-      double c = CalculateCost(n);
-      if (c < costs_[n]) {
-        costs_[n] = c;
-      } else {
-        iterators_[n] = temp_i;
-      }
-      best_ = std::min_element(costs_.begin(), costs_.end()) - costs_.begin();
+      UpdateBest();
+    }
+    if (rng_() % 2 == 0) {
+      const int n = rng_() % n_chromosomes_;
+      MutateIterLeft(n, rng_() % (iterators_[n].size() - 1));
+      UpdateBest();
     } else {
-      int n = rand() % n_chromosomes_;
-      auto temp_i = iterators_[n];
-      MutateIterRight(n, rand() % n_vehicles_);
-      double c = CalculateCost(n);
-      if (c < costs_[n]) {
-        costs_[n] = c;
-      } else {
-        iterators_[n] = temp_i;
-      }
-      best_ = std::min_element(costs_.begin(), costs_.end()) - costs_.begin();
+      const int n = rng_() % n_chromosomes_;
+      MutateIterRight(n, rng_() % (iterators_[n].size() - 1));
+      UpdateBest();
     }
-    if (rand() % total_percentage < p_mutate) {
+    if (rng_() % total_percentage < p_mutate) {
       Mutate();
-      best_ = std::min_element(costs_.begin(), costs_.end()) - costs_.begin();
+      UpdateBest();
     }
-    if (rand() % total_percentage < p_random_swap) {
+    if (rng_() % total_percentage < p_random_swap) {
       RandomSwap();
-      best_ = std::min_element(costs_.begin(), costs_.end()) - costs_.begin();
+      UpdateBest();
     }
-    if (rand() % total_percentage < p_mutate_within_gene) {
+    if (rng_() % total_percentage < p_mutate_within_gene) {
       MutateWhithinGene();
-      best_ = std::min_element(costs_.begin(), costs_.end()) - costs_.begin();
+      UpdateBest();
     }
-    if (rand() % total_percentage < p_insert_iter_dist) {
+    if (rng_() % total_percentage < p_insert_iter_dist) {
       InsertIterDist();
-      best_ = std::min_element(costs_.begin(), costs_.end()) - costs_.begin();
+      UpdateBest();
     }
     // if(rand()%total_percentage<5) {
     //   Addbest();
@@ -360,8 +1078,22 @@ void GASolution::Solve() {
     // if(rand()%total_percentage < n_attempts) {
     //   DeleteBadChromosome();
     // }
+    if (penalty_.enabled_ && penalty_.adjustment_interval_ > 0 &&
+        generation_ % penalty_.adjustment_interval_ ==
+            penalty_.adjustment_interval_ - 1) {
+      AdjustPenalty();
+    }
     CalculateTotalCost();
-    generation++;
+    generation_++;
+    report();
+    if (!checkpoint_path_.empty()) {
+      const auto now = std::chrono::steady_clock::now();
+      const std::chrono::duration<double> since = now - last_checkpoint_;
+      if (since.count() >= checkpoint_interval_) {
+        WriteCheckpoint(*this, checkpoint_path_);
+        last_checkpoint_ = now;
+      }
+    }
     // if(generation%total_percentage==0){
     //   RemoveSimilarSolutions();
     // }
@@ -382,13 +1114,14 @@ void GASolution::Solve() {
     //   solution_string_ += ',' + std::to_string(depot_.id_);
     // }
   }
-  GenerateBestSolution();
+  return generation_ < generations_;
 }
 
-void GASolution::HGreXCrossover() {
+template <typename Gene, typename Cost>
+void GAKernel<Gene, Cost>::HGreXCrossover() {
   const int p1 = TournamentSelection();
   const int p2 = TournamentSelection();
-  std::vector<int> child;
+  std::vector<Gene> child;
   std::unordered_set<int> reached;
   auto *itp1 = &(chromosomes_[p1]);
   auto *itp2 = &(chromosomes_[p2]);
@@ -436,7 +1169,9 @@ void GASolution::HGreXCrossover() {
     reached.insert(n1);
   }
   chromosomes_.push_back(child);
-  int temp = rand() % total_percentage;
+  routes_.emplace_back();
+  excess_.push_back(0);
+  int temp = rng_() % total_percentage;
   constexpr int p_emplace_random_iter = 40;
   constexpr int p_emplace_iter_1 = 60;
   if (temp < p_emplace_random_iter) {
@@ -446,78 +1181,164 @@ void GASolution::HGreXCrossover() {
   } else {
     iterators_.emplace_back(iterators_[p2]);
   }
-  MakeValid(n_chromosomes_);
-  if (checkValidity(n_chromosomes_)) {
-    costs_.emplace_back(CalculateCost(n_chromosomes_));
-    InsertionBySimilarity();
+  if (penalty_.enabled_) {
+    Split(n_chromosomes_);
+  } else {
+    MakeValid(n_chromosomes_);
+  }
+  const auto e = Evaluate(n_chromosomes_);
+  if (e.valid_ || penalty_.enabled_) {
+    if (education_.enabled_) {
+      Educate(n_chromosomes_);
+      costs_.emplace_back(CalculateCost(n_chromosomes_));
+    } else {
+      costs_.emplace_back(Fitness(e));
+    }
+    if (penalty_.enabled_) {
+      n_children_++;
+      if (excess_.back() == 0) {
+        n_feasible_children_++;
+      }
+      SubpopulationSelection();
+    } else {
+      InsertionBySimilarity();
+    }
   } else {
-    iterators_.erase(iterators_.begin() + n_chromosomes_ - 1);
-    chromosomes_.erase(chromosomes_.begin() + n_chromosomes_ - 1);
+    iterators_.pop_back();
+    chromosomes_.pop_back();
+    routes_.pop_back();
+    excess_.pop_back();
   }
 }
 
 // Works if and only if a solution is possible. No check on validity after
 // function executes
-void GASolution::MakeValid(const int i) {
-  for (int j = 0; j < n_vehicles_ - 1; j++) {
-    int load = capacity_;
-    int iter = iterators_[i][j];
-    while (iter < iterators_[i][j + 1]) {
-      load -= nodes_[chromosomes_[i][iter]].demand_;
-      ++iter;
+template <typename Gene, typename Cost>
+void GAKernel<Gene, Cost>::MakeValid(const int i) {
+  Invalidate(i);
+  const auto &c = chromosomes_[i];
+  auto &it = iterators_[i];
+  it.erase(std::unique(it.begin(), it.end()), it.end());
+  for (size_t k = 0; k + 1 < it.size(); k++) {
+    int load = 0;
+    int end = it[k];
+    while (end < it[k + 1] && load + nodes_[c[end]].demand_ <= capacity_) {
+      load += nodes_[c[end]].demand_;
+      ++end;
     }
-    if (load < 0) {
-      iterators_[i][j + 1]--;
-      j--;
+    // A node that can not be carried by any vehicle stays on its own
+    if (end == it[k]) {
+      end++;
+    }
+    if (end == it[k + 1]) {
+      continue;
+    }
+    if (k + 2 < it.size()) {
+      it[k + 1] = end;
+    } else if (it.size() <= n_vehicles_) {
+      it.insert(it.begin() + k + 1, end);
+    } else {
+      break;
     }
   }
 
-  for (int j = n_vehicles_; j > 1; j--) {
+  // No vehicle left for the nodes that do not fit into the last routes; they
+  // are pushed back into the preceding routes
+  for (size_t k = it.size() - 1; k > 1; k--) {
     int load = capacity_;
-    int iter = iterators_[i][j] - 1;
-    while (iter >= iterators_[i][j - 1]) {
-      load -= nodes_[chromosomes_[i][iter]].demand_;
+    int iter = it[k] - 1;
+    while (iter >= it[k - 1]) {
+      load -= nodes_[c[iter]].demand_;
       --iter;
     }
     if (load < 0) {
-      iterators_[i][j - 1]++;
-      j++;
+      it[k - 1]++;
+      k++;
     }
   }
+  it.erase(std::unique(it.begin(), it.end()), it.end());
 }
 
-void GASolution::DeleteBadChromosome() {
+template <typename Gene, typename Cost>
+void GAKernel<Gene, Cost>::Split(const int i) {
+  Invalidate(i);
+  const auto &c = chromosomes_[i];
+  const int n = c.size();
+  // Overloaded routes are allowed, within a limit, at the current penalty
+  constexpr int max_overload_percentage = 50;
+  const int max_load =
+      capacity_ + capacity_ * max_overload_percentage / total_percentage;
+  // Lowest cost of splitting the first b nodes into routes
+  std::vector<Cost> potential{0};
+  potential.resize(n + 1, std::numeric_limits<Cost>::max());
+  std::vector<int> pred(n + 1, 0);
+  for (int a = 0; a < n; a++) {
+    int load = 0;
+    Cost distance = 0;
+    for (int b = a + 1; b <= n; b++) {
+      const int node = c[b - 1];
+      load += evaluator_.Demand(node);
+      if (load > max_load && b > a + 1) {
+        break;
+      }
+      distance += (b == a + 1) ? evaluator_.Distance(0, node)
+                               : evaluator_.Distance(c[b - 2], node);
+      const Cost cost = potential[a] + distance +
+                        evaluator_.Distance(node, 0) + Penalty(load);
+      if (cost < potential[b]) {
+        potential[b] = cost;
+        pred[b] = a;
+      }
+    }
+  }
+  std::vector<Gene> it;
+  for (int b = n; b > 0; b = pred[b]) {
+    it.push_back(b);
+  }
+  it.push_back(0);
+  if (it.size() > n_vehicles_ + 1) {
+    MakeValid(i);
+    return;
+  }
+  std::reverse(it.begin(), it.end());
+  iterators_[i] = std::move(it);
+}
+
+template <typename Gene, typename Cost>
+void GAKernel<Gene, Cost>::DeleteBadChromosome() {
   const int i = TournamentSelectionBad();
   chromosomes_[i] = GenerateRandomSolution();
+  Invalidate(i);
 }
 
-int GASolution::TournamentSelection(const int n) const {
+template <typename Gene, typename Cost>
+int GAKernel<Gene, Cost>::TournamentSelection(const int n) const {
   std::vector<int> indices(n);
   generate(indices.begin(), indices.end(),
-           [this]() { return rand() % chromosomes_.size(); });
+           [this]() { return rng_() % chromosomes_.size(); });
   return *std::min_element(
       std::begin(indices), std::end(indices),
       [this](const int i1, const int i2) { return costs_[i1] < costs_[i2]; });
 }
 
-int GASolution::TournamentSelectionBad(const int n) const {
+template <typename Gene, typename Cost>
+int GAKernel<Gene, Cost>::TournamentSelectionBad(const int n) const {
   std::vector<int> indices(n);
   generate(indices.begin(), indices.end(),
-           [this]() { return rand() % chromosomes_.size(); });
+           [this]() { return rng_() % chromosomes_.size(); });
   return *std::max_element(
       std::begin(indices), std::end(indices),
       [this](const int i1, const int i2) { return costs_[i1] < costs_[i2]; });
 }
 
-void GASolution::InsertionBySimilarity() {
-  best_ = std::min_element(costs_.begin(), costs_.end()) - costs_.begin();
+template <typename Gene, typename Cost>
+void GAKernel<Gene, Cost>::InsertionBySimilarity() {
+  UpdateBest();
   bool flag = true;
-  for (int i = 0; i < n_nucleotide_pairs_; ++i) {
+  for (size_t i = 0; i < costs_.size(); ++i) {
     if (i != best_ &&
         costs_.back() - costs_[i] < 2 * (costs_[best_] / total_percentage)) {
-      costs_.erase(costs_.begin() + i);
-      chromosomes_.erase(chromosomes_.begin() + i);
-      iterators_.erase(iterators_.begin() + i);
+      EraseChromosome(i);
       flag = false;
       break;
     }
@@ -527,313 +1348,418 @@ void GASolution::InsertionBySimilarity() {
   }
 }
 
-void GASolution::DeleteRandomChromosome() {
-  int r = rand() % n_chromosomes_;
+template <typename Gene, typename Cost>
+void GAKernel<Gene, Cost>::DeleteRandomChromosome() {
+  int r = rng_() % n_chromosomes_;
   while (r == best_) {
-    r = rand() % n_chromosomes_;
+    r = rng_() % n_chromosomes_;
   }
   chromosomes_[r] = chromosomes_.back();
   iterators_[r] = iterators_.back();
+  routes_[r] = routes_.back();
+  costs_[r] = costs_.back();
+  excess_[r] = excess_.back();
   chromosomes_.erase(chromosomes_.begin() + chromosomes_.size() - 1);
   iterators_.erase(iterators_.begin() + iterators_.size() - 1);
+  routes_.pop_back();
+  costs_.pop_back();
+  excess_.pop_back();
 }
 
-void GASolution::Mutate() {
+template <typename Gene, typename Cost>
+void GAKernel<Gene, Cost>::Mutate() {
   int count = 0;
   constexpr int n_attempts = 20;
   while (count < n_attempts) {
-    best_ = std::min_element(costs_.begin(), costs_.end()) - costs_.begin();
-    int r = rand() % n_chromosomes_;
+    UpdateBest();
+    int r = rng_() % n_chromosomes_;
     while (r == best_) {
-      r = rand() % n_chromosomes_;
+      r = rng_() % n_chromosomes_;
     }
-    size_t i1 = rand() % n_nucleotide_pairs_;
-    size_t i2 = rand() % n_nucleotide_pairs_;
+    size_t i1 = rng_() % n_nucleotide_pairs_;
+    size_t i2 = rng_() % n_nucleotide_pairs_;
     if (i1 > i2) {
       std::swap(i1, i2);
     }
     auto temp_it = iterators_[r];
     std::reverse(chromosomes_[r].begin() + i1, chromosomes_[r].begin() + i2);
-    MakeValid(r);
-    const double p = costs_[r];
-    costs_[r] = CalculateCost(r);
+    if (penalty_.enabled_) {
+      Split(r);
+    } else {
+      MakeValid(r);
+    }
+    const Cost p = costs_[r];
+    const int x = excess_[r];
+    const auto e = Evaluate(r);
+    costs_[r] = Fitness(e);
     if (p < costs_[r]) {
       std::reverse(chromosomes_[r].begin() + i1, chromosomes_[r].begin() + i2);
       iterators_[r] = temp_it;
+      Invalidate(r);
       count++;
       costs_[r] = p;
-    } else if (checkValidity(r)) {
+      excess_[r] = x;
+    } else if (e.valid_ || penalty_.enabled_) {
       break;
     }
   }
 }
 
-void GASolution::SwapWhithinGene() {
+template <typename Gene, typename Cost>
+void GAKernel<Gene, Cost>::SwapWhithinGene() {
   int count = 0;
   constexpr int n_attempts = 20;
   while (count < n_attempts) {
-    best_ = std::min_element(costs_.begin(), costs_.end()) - costs_.begin();
-    int r = rand() % n_chromosomes_;
+    UpdateBest();
+    int r = rng_() % n_chromosomes_;
     // while(r==best_) r = rand()%n_chromosomes_;
-    int v = rand() % n_vehicles_;
-    int delta = iterators_[r][v + 1] - iterators_[r][v];
-    if (delta < 1) {
-      return;
-    }
-    int i1 = iterators_[r][v] + rand() % delta;
-    int i2 = iterators_[r][v] + rand() % delta;
+    const int v = rng_() % (iterators_[r].size() - 1);
+    const int delta = iterators_[r][v + 1] - iterators_[r][v];
+    int i1 = iterators_[r][v] + rng_() % delta;
+    int i2 = iterators_[r][v] + rng_() % delta;
     std::swap(chromosomes_[r][i1], chromosomes_[r][i2]);
     auto temp_it = iterators_[r];
-    MakeValid(r);
-    double p = costs_[r];
-    costs_[r] = CalculateCost(r);
+    if (penalty_.enabled_) {
+      Split(r);
+    } else {
+      MakeValid(r);
+    }
+    const Cost p = costs_[r];
+    const int x = excess_[r];
+    const auto e = Evaluate(r);
+    costs_[r] = Fitness(e);
     if (p < costs_[r]) {
       std::swap(chromosomes_[r][i1], chromosomes_[r][i2]);
       iterators_[r] = temp_it;
+      Invalidate(r);
       count++;
       costs_[r] = p;
-    } else if (checkValidity(r)) {
+      excess_[r] = x;
+    } else if (e.valid_ || penalty_.enabled_) {
       break;
     }
   }
 }
 
-void GASolution::MutateWhithinGene() {
+template <typename Gene, typename Cost>
+void GAKernel<Gene, Cost>::MutateWhithinGene() {
   int count = 0;
   constexpr int n_attempts = 20;
   while (count < n_attempts) {
-    best_ = std::min_element(costs_.begin(), costs_.end()) - costs_.begin();
-    int r = rand() % n_chromosomes_;
+    UpdateBest();
+    int r = rng_() % n_chromosomes_;
     while (r == best_) {
-      r = rand() % n_chromosomes_;
-    }
-    int v = rand() % n_vehicles_;
-    int delta = iterators_[r][v + 1] - iterators_[r][v];
-    if (delta < 1) {
-      return;
+      r = rng_() % n_chromosomes_;
     }
-    int i1 = iterators_[r][v] + rand() % delta;
-    int i2 = iterators_[r][v] + rand() % delta;
+    const int v = rng_() % (iterators_[r].size() - 1);
+    const int delta = iterators_[r][v + 1] - iterators_[r][v];
+    int i1 = iterators_[r][v] + rng_() % delta;
+    int i2 = iterators_[r][v] + rng_() % delta;
     if (i1 > i2) {
       std::swap(i1, i2);
     }
     std::reverse(chromosomes_[r].begin() + i1, chromosomes_[r].begin() + i2);
     const auto temp_it = iterators_[r];
-    MakeValid(r);
-    double p = costs_[r];
-    costs_[r] = CalculateCost(r);
+    if (penalty_.enabled_) {
+      Split(r);
+    } else {
+      MakeValid(r);
+    }
+    const Cost p = costs_[r];
+    const int x = excess_[r];
+    const auto e = Evaluate(r);
+    costs_[r] = Fitness(e);
     if (p < costs_[r]) {
       std::reverse(chromosomes_[r].begin() + i1, chromosomes_[r].begin() + i2);
       iterators_[r] = temp_it;
+      Invalidate(r);
       count++;
       costs_[r] = p;
-    } else if (checkValidity(r)) {
+      excess_[r] = x;
+    } else if (e.valid_ || penalty_.enabled_) {
       break;
     }
   }
 }
 
-bool GASolution::MutateIterLeft(const int i_chromosome, const int j_in) {
-  if (j_in == n_vehicles_ || j_in == 0) {
+template <typename Gene, typename Cost>
+bool GAKernel<Gene, Cost>::MutateIterLeft(const int i_chromosome,
+                                          const int j_in) {
+  const int i = i_chromosome;
+  const int j = j_in;
+  const auto &c = chromosomes_[i];
+  auto &it = iterators_[i];
+  if (j <= 0 || j >= int(it.size()) - 1) {
     return false;
   }
-
-  int i = i_chromosome;
-  if (iterators_[i][j_in] > iterators_[i][j_in - 1]) {
-    iterators_[i][j_in]--;
+  if (it[j] <= it[j - 1]) {
+    return false;
   }
-  for (int j = j_in; j < n_vehicles_ - 1; j++) {
-    int load = capacity_;
-    int iter = iterators_[i][j];
-    while (iter < iterators_[i][j + 1]) {
-      load -= nodes_[chromosomes_[i][iter]].demand_;
-      ++iter;
-    }
-    if (load < 0) {
-      iterators_[i][j + 1]--;
-      j--;
-    }
+  auto &r = CachedRoutes(i);
+  const int node = c[it[j] - 1];
+  const int demand = evaluator_.Demand(node);
+  if (!penalty_.enabled_ && r.loads_[j] + demand > capacity_) {
+    return false;
   }
-
-  for (int j = n_vehicles_; j > 1; j--) {
-    int load = capacity_;
-    int iter = iterators_[i][j] - 1;
-    while (iter >= iterators_[i][j - 1]) {
-      load -= nodes_[chromosomes_[i][iter]].demand_;
-      --iter;
-    }
-    if (load < 0) {
-      iterators_[i][j - 1]++;
-      j++;
-    }
+  // Last node of route j - 1 becomes the first node of route j
+  const int prev = (it[j] - 1 > it[j - 1]) ? c[it[j] - 2] : 0;
+  const int next = (it[j + 1] > it[j]) ? c[it[j]] : 0;
+  const auto d = [this](const int a, const int b) {
+    return evaluator_.Distance(a, b);
+  };
+  const Cost cost_prev =
+      r.costs_[j - 1] - d(prev, node) - d(node, 0) + d(prev, 0);
+  const Cost cost_next = r.costs_[j] - d(0, next) + d(0, node) + d(node, next);
+  const int load_prev = r.loads_[j - 1] - demand;
+  const int load_next = r.loads_[j] + demand;
+  const int excess = std::max(0, load_prev - capacity_) +
+                     std::max(0, load_next - capacity_) -
+                     std::max(0, r.loads_[j - 1] - capacity_) -
+                     std::max(0, r.loads_[j] - capacity_);
+  const Cost delta = (cost_prev - r.costs_[j - 1]) +
+                     (cost_next - r.costs_[j]) +
+                     penalty_cost_ * static_cast<Cost>(excess);
+  if (!(delta < 0)) {
+    return false;
+  }
+  costs_[i] += delta;
+  excess_[i] += excess;
+  it[j]--;
+  if (it[j] == it[j - 1]) {
+    // Route j - 1 is empty and its vehicle is no longer used
+    it.erase(it.begin() + j);
+    Invalidate(i);
+    return true;
   }
+  r.loads_[j - 1] = load_prev;
+  r.loads_[j] = load_next;
+  SetRouteCost(r, j - 1, cost_prev);
+  SetRouteCost(r, j, cost_next);
   return true;
 }
 
-bool GASolution::MutateIterRight(const int i_chromosome, const int j_in) {
-  if (j_in == n_vehicles_ || j_in == 0) {
+template <typename Gene, typename Cost>
+bool GAKernel<Gene, Cost>::MutateIterRight(const int i_chromosome,
+                                           const int j_in) {
+  const int i = i_chromosome;
+  const int j = j_in;
+  const auto &c = chromosomes_[i];
+  auto &it = iterators_[i];
+  if (j <= 0 || j >= int(it.size()) - 1) {
     return false;
   }
-  int i = i_chromosome;
-  if (iterators_[i][j_in] < iterators_[i][j_in - 1]) {
-    iterators_[i][j_in]++;
+  if (it[j] >= it[j + 1]) {
+    return false;
   }
-  for (int j = j_in; j > 1; j--) {
-    int load = capacity_;
-    int iter = iterators_[i][j] - 1;
-    while (iter >= iterators_[i][j - 1]) {
-      load -= nodes_[chromosomes_[i][iter]].demand_;
-      --iter;
-    }
-    if (load < 0) {
-      iterators_[i][j - 1]++;
-      j++;
-    }
+  auto &r = CachedRoutes(i);
+  const int node = c[it[j]];
+  const int demand = evaluator_.Demand(node);
+  if (!penalty_.enabled_ && r.loads_[j - 1] + demand > capacity_) {
+    return false;
   }
-
-  for (int j = 0; j < n_vehicles_ - 1; j++) {
-    int load = capacity_;
-    int iter = iterators_[i][j];
-    while (iter < iterators_[i][j + 1]) {
-      load -= nodes_[chromosomes_[i][iter]].demand_;
-      ++iter;
-    }
-    if (load < 0) {
-      iterators_[i][j + 1]--;
-      j--;
-    }
+  // First node of route j becomes the last node of route j - 1
+  const int prev = (it[j] > it[j - 1]) ? c[it[j] - 1] : 0;
+  const int next = (it[j] + 1 < it[j + 1]) ? c[it[j] + 1] : 0;
+  const auto d = [this](const int a, const int b) {
+    return evaluator_.Distance(a, b);
+  };
+  const Cost cost_prev =
+      r.costs_[j - 1] - d(prev, 0) + d(prev, node) + d(node, 0);
+  const Cost cost_next = r.costs_[j] - d(0, node) - d(node, next) + d(0, next);
+  const int load_prev = r.loads_[j - 1] + demand;
+  const int load_next = r.loads_[j] - demand;
+  const int excess = std::max(0, load_prev - capacity_) +
+                     std::max(0, load_next - capacity_) -
+                     std::max(0, r.loads_[j - 1] - capacity_) -
+                     std::max(0, r.loads_[j] - capacity_);
+  const Cost delta = (cost_prev - r.costs_[j - 1]) +
+                     (cost_next - r.costs_[j]) +
+                     penalty_cost_ * static_cast<Cost>(excess);
+  if (!(delta < 0)) {
+    return false;
+  }
+  costs_[i] += delta;
+  excess_[i] += excess;
+  it[j]++;
+  if (it[j] == it[j + 1]) {
+    // Route j is empty and its vehicle is no longer used
+    it.erase(it.begin() + j);
+    Invalidate(i);
+    return true;
   }
+  r.loads_[j - 1] = load_prev;
+  r.loads_[j] = load_next;
+  SetRouteCost(r, j - 1, cost_prev);
+  SetRouteCost(r, j, cost_next);
   return true;
 }
 
-bool GASolution::checkValidity(const int i) const {
-  for (int j = 0; j < n_vehicles_; j++) {
-    int load = capacity_;
-    int iter = iterators_[i][j];
-    while (iter < iterators_[i][j + 1]) {
-      load -= nodes_[chromosomes_[i][iter]].demand_;
-      ++iter;
-    }
-    if (load < 0) {
-      return false;
-    }
-  }
-  return true;
+template <typename Gene, typename Cost>
+bool GAKernel<Gene, Cost>::checkValidity(const int i) {
+  return Evaluate(i).valid_;
 }
 
-void GASolution::RandomSwap() {
+template <typename Gene, typename Cost>
+void GAKernel<Gene, Cost>::RandomSwap() {
   int count = 0;
   constexpr int n_attempts = 20;
   while (count < n_attempts) {
-    best_ = std::min_element(costs_.begin(), costs_.end()) - costs_.begin();
-    int r = rand() % n_chromosomes_;
+    UpdateBest();
+    int r = rng_() % n_chromosomes_;
     while (r == best_) {
-      r = rand() % n_chromosomes_;
+      r = rng_() % n_chromosomes_;
     }
-    size_t i1 = rand() % n_nucleotide_pairs_;
-    size_t i2 = rand() % n_nucleotide_pairs_;
+    size_t i1 = rng_() % n_nucleotide_pairs_;
+    size_t i2 = rng_() % n_nucleotide_pairs_;
     std::swap(chromosomes_[r][i1], chromosomes_[r][i2]);
     const auto temp_it = iterators_[r];
-    MakeValid(r);
-    double p = costs_[r];
-    costs_[r] = CalculateCost(r);
+    if (penalty_.enabled_) {
+      Split(r);
+    } else {
+      MakeValid(r);
+    }
+    const Cost p = costs_[r];
+    const int x = excess_[r];
+    const auto e = Evaluate(r);
+    costs_[r] = Fitness(e);
     if (p < costs_[r]) {
       std::swap(chromosomes_[r][i1], chromosomes_[r][i2]);
       iterators_[r] = temp_it;
+      Invalidate(r);
       count++;
       costs_[r] = p;
-    } else if (checkValidity(r)) {
+      excess_[r] = x;
+    } else if (e.valid_ || penalty_.enabled_) {
       break;
     }
   }
 }
 
-void GASolution::AddBest() {
-  best_ = std::min_element(costs_.begin(), costs_.end()) - costs_.begin();
+template <typename Gene, typename Cost>
+void GAKernel<Gene, Cost>::AddBest() {
+  UpdateBest();
   const int worst =
       std::min_element(costs_.begin(), costs_.end()) - costs_.begin();
   chromosomes_[worst] = chromosomes_[best_];
   costs_[worst] = costs_[best_];
   iterators_[worst] = iterators_[best_];
+  routes_[worst] = routes_[best_];
+  excess_[worst] = excess_[best_];
 }
 
-void GASolution::DeleteWorstChromosome() {
+template <typename Gene, typename Cost>
+void GAKernel<Gene, Cost>::DeleteWorstChromosome() {
   const auto it = std::max_element(costs_.begin(), costs_.end());
-  const int dist = std::distance(costs_.begin(), it);
-  costs_.erase(it);
-  chromosomes_.erase(std::next(chromosomes_.begin(), dist));
-  iterators_.erase(std::next(iterators_.begin(), dist));
+  EraseChromosome(std::distance(costs_.begin(), it));
 }
 
-void GASolution::InsertIterDist() {
-  const int n = rand() % n_chromosomes_;
-  auto temp = iterators_[n];
-  int j = n_vehicles_;
-  while (iterators_[n][j] == n_nucleotide_pairs_) {
-    j--;
+template <typename Gene, typename Cost>
+void GAKernel<Gene, Cost>::InsertIterDist() {
+  const int n = rng_() % n_chromosomes_;
+  auto &it = iterators_[n];
+  // All the vehicles are in use
+  if (it.size() > n_vehicles_) {
+    return;
   }
-  if (j == n_vehicles_ - 1) {
+  const int i = LongestRoute(n);
+  const int range = it[i + 1] - it[i];
+  if (routes_[n].costs_[i] == 0 || range < 2) {
     return;
   }
-  j++;
-  // that found the iterator to insert
-  double cost = 0;
-  int iter_begin = 0;
-  int range = 0;
-  for (int i = 0; i < n_vehicles_; i++) {
-    int c = 0;
-    c += distanceMatrix_[0][iterators_[n][i]];
-    for (int k = iterators_[n][i]; k < iterators_[n][i + 1] - 1; k++) {
-      c += distanceMatrix_[chromosomes_[n][k]][chromosomes_[n][k + 1]];
-    }
-    if (iterators_[n][i + 1] - iterators_[n][i] < 2) {
-      continue;
+  const int val = it[i] + rng_() % (range - 1) + 1;
+  const int last = chromosomes_[n][val - 1];
+  const int first = chromosomes_[n][val];
+  Cost delta = evaluator_.Distance(last, 0) + evaluator_.Distance(0, first) -
+               evaluator_.Distance(last, first);
+  if (penalty_.enabled_) {
+    int load = 0;
+    for (int k = it[i]; k < val; k++) {
+      load += evaluator_.Demand(chromosomes_[n][k]);
     }
-    c += distanceMatrix_[iterators_[n][i + 1] - 1][0];
-    if (c > cost) {
-      cost = c;
-      iter_begin = i;
-      range = iterators_[n][i + 1] - iterators_[n][i];
+    const int total = routes_[n].loads_[i];
+    delta += Penalty(load) + Penalty(total - load) - Penalty(total);
+  }
+  if (delta > 0) {
+    return;
+  }
+  it.insert(it.begin() + i + 1, val);
+  // Every route after the split has moved, so the routes are evaluated again
+  costs_[n] = Fitness(Evaluate(n));
+}
+
+template <typename Gene, typename Cost>
+std::vector<Vehicle> GAKernel<Gene, Cost>::DecodeRoutes(const int i) const {
+  std::vector<Vehicle> routes;
+  routes.reserve(iterators_[i].size() - 1);
+  for (size_t k = 0; k + 1 < iterators_[i].size(); k++) {
+    Vehicle v(vehicles_[k].id_, capacity_, capacity_);
+    v.nodes_.push_back(depot_.id_);
+    for (int j = iterators_[i][k]; j < iterators_[i][k + 1]; j++) {
+      v.nodes_.push_back(chromosomes_[i][j]);
+      v.load_ -= nodes_[chromosomes_[i][j]].demand_;
     }
+    v.nodes_.push_back(depot_.id_);
+    v.CalculateCost(distanceMatrix_);
+    routes.push_back(std::move(v));
   }
-  int i = iter_begin;
-  if (cost == 0 || range < 2) {
+  return routes;
+}
+
+template <typename Gene, typename Cost>
+void GAKernel<Gene, Cost>::Educate(const int i) {
+  auto routes = DecodeRoutes(i);
+  size_t n_routed = 0;
+  for (const auto &v : routes) {
+    n_routed += v.nodes_.size() - 2;
+  }
+  // Iterators that are out of order do not describe a split of the chromosome
+  if (n_routed != n_nucleotide_pairs_) {
     return;
   }
-  const int val = iterators_[n][i] + rand() % (range - 1) + 1;
-  iterators_[n].erase(iterators_[n].begin() + j);
-  iterators_[n].insert(iterators_[n].begin() + i + 1, val);
-  MakeValid(n);  // dont think this is req
-  if (!checkValidity(n)) {
-    std::cout << "Invalid from insertiterdist" << '\n';
+  if (EducateRoutes(routes, nodes_, distanceMatrix_, neighbors_,
+                    education_) == 0) {
+    return;
   }
-  const double c2 = CalculateCost(n);
-  if (costs_[n] < c2) {
-    iterators_[n] = temp;
-  } else {
-    costs_[n] = c2;
+  // Routes emptied by the education are dropped
+  int j = 0;
+  iterators_[i].assign(1, 0);
+  for (const auto &v : routes) {
+    if (v.nodes_.size() > 2) {
+      for (size_t l = 1; l < v.nodes_.size() - 1; l++) {
+        chromosomes_[i][j++] = v.nodes_[l];
+      }
+      iterators_[i].push_back(j);
+    }
   }
+  Invalidate(i);
 }
 
-void GASolution::GenerateBestSolution() {
+template <typename Gene, typename Cost>
+void GAKernel<Gene, Cost>::GenerateBestSolution() {
   auto it = std::min_element(costs_.begin(), costs_.end());
   int i = it - costs_.begin();
+  const bool use_incumbent = penalty_.enabled_ && incumbent_.found_;
+  const auto &chromosome =
+      use_incumbent ? incumbent_.chromosome_ : chromosomes_[i];
+  const auto &iterators = use_incumbent ? incumbent_.iterators_ : iterators_[i];
+  // Called again whenever Step() reports a better solution
+  for (auto &vehicle : vehicles_) {
+    vehicle.nodes_.assign(1, depot_.id_);
+    vehicle.load_ = capacity_;
+  }
   auto v = vehicles_.begin();
-  for (size_t k = 0; k < iterators_[0].size() - 1; k++, v++) {
+  for (size_t k = 0; k + 1 < iterators.size(); k++, v++) {
     v->cost_ = 0;
-    if (iterators_[i][k] == n_nucleotide_pairs_) {
-      break;
+    int j = iterators[k];
+    if (j < iterators[k + 1]) {
+      v->cost_ += distanceMatrix_[0][chromosome[j]];
+      v->nodes_.push_back(chromosome[j]);
+      v->load_ -= nodes_[chromosome[j]].demand_;
     }
-    int j = iterators_[i][k];
-    if (j < iterators_[i][k + 1]) {
-      v->cost_ += distanceMatrix_[0][chromosomes_[i][j]];
-      v->nodes_.push_back(chromosomes_[i][j]);
-      v->load_ -= nodes_[chromosomes_[i][j]].demand_;
-    }
-    while (j + 1 < iterators_[i][k + 1]) {
-      v->cost_ += distanceMatrix_[chromosomes_[i][j]][chromosomes_[i][j + 1]];
-      v->nodes_.push_back(chromosomes_[i][j + 1]);
-      v->load_ -= nodes_[chromosomes_[i][j + 1]].demand_;
+    while (j + 1 < iterators[k + 1]) {
+      v->cost_ += distanceMatrix_[chromosome[j]][chromosome[j + 1]];
+      v->nodes_.push_back(chromosome[j + 1]);
+      v->load_ -= nodes_[chromosome[j + 1]].demand_;
       j++;
     }
     v->cost_ += distanceMatrix_[v->nodes_.back()][depot_.id_];
@@ -843,6 +1769,12 @@ void GASolution::GenerateBestSolution() {
     v->cost_ = 0;
     ++v;
   }
-  std::cout << "\n";
   //PrintSolution("route");
 }
+
+template class GAKernel<uint16_t, double>;
+template class GAKernel<uint16_t, float>;
+template class GAKernel<uint16_t, int32_t>;
+template class GAKernel<int32_t, double>;
+template class GAKernel<int32_t, float>;
+template class GAKernel<int32_t, int32_t>;
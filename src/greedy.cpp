@@ -12,25 +12,29 @@
 #include <iomanip>
 #include <ctime>
 
+#include "cvrp/kd_tree.hpp"
+
 GreedySolution::GreedySolution(
     const std::vector<Node>& nodes, const std::vector<Vehicle>& vehicles,
     const std::vector<std::vector<double>>& distanceMatrix)
     : Solution(nodes, vehicles, distanceMatrix) {}
 
 GreedySolution::GreedySolution(const Problem& p)
-    : Solution(p.nodes_, p.vehicles_, p.distanceMatrix_) {}
+    : Solution(p) {}
 
 void GreedySolution::Solve() {
+  auto unrouted = UnroutedIndex();
   for (auto& v : vehicles_) {
     while (true) {
-      const auto [found, closest_node] = find_closest(v);
+      const auto [found, closest_node] = find_closest(v, unrouted);
       if (found && v.load_ - closest_node.demand_ >= 0) {
         v.load_ -= closest_node.demand_;
-        v.cost_ += distanceMatrix_[v.nodes_.back()][closest_node.id_];
+        v.cost_ += (*distanceMatrix_)[v.nodes_.back()][closest_node.id_];
         v.nodes_.push_back(closest_node.id_);
         nodes_[closest_node.id_].is_routed_ = true;
+        unrouted.Erase(closest_node.id_);
       } else {
-        v.cost_ += distanceMatrix_[v.nodes_.back()][depot_.id_];
+        v.cost_ += (*distanceMatrix_)[v.nodes_.back()][depot_.id_];
         v.nodes_.push_back(depot_.id_);
         break;
       }
@@ -42,10 +46,13 @@ void GreedySolution::Solve() {
       std::begin(vehicles_), std::end(vehicles_), 0.0,
       [](const double sum, const Vehicle& v) { return sum + v.cost_; });
   
+  if (!verbose_) {
+    return;
+  }
   for (const auto& i : nodes_) {
     if (!i.is_routed_) {
       std::cout << "\t Unreached node: ";
-      std::cout << i << '\n';
+      std::cout << OriginalNode(i) << '\n';
     }
   }
   
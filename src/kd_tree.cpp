@@ -0,0 +1,181 @@
+/**
+ * @file kd_tree.cpp
+ * @author vss2sn
+ * @brief Contains the KdTree class, a spatial index over the locations of the
+ * nodes
+ */
+
+#include "cvrp/kd_tree.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <queue>
+#include <utility>
+
+KdTree::KdTree(const std::vector<Node> &nodes, std::vector<int> ids)
+    : ids_(std::move(ids)),
+      x_(ids_.size()),
+      y_(ids_.size()),
+      demand_(ids_.size()),
+      axis_(ids_.size(), 0),
+      erased_(ids_.size(), false),
+      min_demand_(ids_.size()),
+      left_(ids_.size(), -1),
+      right_(ids_.size(), -1),
+      parent_(ids_.size(), -1),
+      position_(nodes.size(), -1) {
+  for (size_t i = 0; i < ids_.size(); i++) {
+    x_[i] = nodes[ids_[i]].x_;
+    y_[i] = nodes[ids_[i]].y_;
+    demand_[i] = nodes[ids_[i]].demand_;
+  }
+  Build(0, ids_.size(), -1);
+  for (size_t i = 0; i < ids_.size(); i++) {
+    position_[ids_[i]] = i;
+  }
+}
+
+int KdTree::Build(const int lo, const int hi, const int parent) {
+  if (lo >= hi) {
+    return -1;
+  }
+  if (hi - lo == 1) {
+    parent_[lo] = parent;
+    min_demand_[lo] = demand_[lo];
+    return lo;
+  }
+  const auto [min_x, max_x] =
+      std::minmax_element(x_.begin() + lo, x_.begin() + hi);
+  const auto [min_y, max_y] =
+      std::minmax_element(y_.begin() + lo, y_.begin() + hi);
+  const unsigned char axis = (*max_x - *min_x >= *max_y - *min_y) ? 0 : 1;
+  const auto &key = (axis == 0) ? x_ : y_;
+
+  // Partition a permutation of the range and apply it to all the arrays
+  std::vector<int> order(hi - lo);
+  std::iota(order.begin(), order.end(), lo);
+  const int mid = (lo + hi) / 2;
+  std::nth_element(order.begin(), order.begin() + (mid - lo), order.end(),
+                   [&key, this](const int a, const int b) {
+                     return key[a] < key[b] ||
+                            (key[a] == key[b] && ids_[a] < ids_[b]);
+                   });
+  std::vector<int> ids(order.size());
+  std::vector<float> xs(order.size());
+  std::vector<float> ys(order.size());
+  std::vector<float> demands(order.size());
+  for (size_t i = 0; i < order.size(); i++) {
+    ids[i] = ids_[order[i]];
+    xs[i] = x_[order[i]];
+    ys[i] = y_[order[i]];
+    demands[i] = demand_[order[i]];
+  }
+  std::copy(ids.begin(), ids.end(), ids_.begin() + lo);
+  std::copy(xs.begin(), xs.end(), x_.begin() + lo);
+  std::copy(ys.begin(), ys.end(), y_.begin() + lo);
+  std::copy(demands.begin(), demands.end(), demand_.begin() + lo);
+  axis_[mid] = axis;
+  parent_[mid] = parent;
+  left_[mid] = Build(lo, mid, mid);
+  right_[mid] = Build(mid + 1, hi, mid);
+  UpdateMinDemand(mid);
+  return mid;
+}
+
+void KdTree::UpdateMinDemand(const int i) {
+  float min_demand = erased_[i] ? std::numeric_limits<float>::max()
+                                : demand_[i];
+  if (left_[i] != -1) {
+    min_demand = std::min(min_demand, min_demand_[left_[i]]);
+  }
+  if (right_[i] != -1) {
+    min_demand = std::min(min_demand, min_demand_[right_[i]]);
+  }
+  min_demand_[i] = min_demand;
+}
+
+void KdTree::Erase(const int id) {
+  if (id < 0 || size_t(id) >= position_.size() || position_[id] == -1 ||
+      erased_[position_[id]]) {
+    return;
+  }
+  erased_[position_[id]] = true;
+  for (int i = position_[id]; i != -1; i = parent_[i]) {
+    UpdateMinDemand(i);
+  }
+}
+
+double KdTree::Distance2(const float x, const float y, const int i) const {
+  // Differences are taken in single precision to match the distance matrix
+  const double dx = x - x_[i];
+  const double dy = y - y_[i];
+  return dx * dx + dy * dy;
+}
+
+std::vector<int> KdTree::Nearest(const float x, const float y, const size_t k,
+                                 const int exclude) const {
+  // Max heap of the best candidates found so far, worst on top
+  std::priority_queue<std::pair<double, int>> best;
+  const auto search = [&](const auto &self, const int lo, const int hi) -> void {
+    if (lo >= hi || k == 0) {
+      return;
+    }
+    const int mid = (lo + hi) / 2;
+    if (ids_[mid] != exclude) {
+      const std::pair<double, int> candidate{Distance2(x, y, mid), ids_[mid]};
+      if (best.size() < k) {
+        best.push(candidate);
+      } else if (candidate < best.top()) {
+        best.pop();
+        best.push(candidate);
+      }
+    }
+    const double diff = (axis_[mid] == 0) ? x - x_[mid] : y - y_[mid];
+    const bool left_first = diff < 0;
+    if (left_first) {
+      self(self, lo, mid);
+    } else {
+      self(self, mid + 1, hi);
+    }
+    if (best.size() < k || diff * diff <= best.top().first) {
+      if (left_first) {
+        self(self, mid + 1, hi);
+      } else {
+        self(self, lo, mid);
+      }
+    }
+  };
+  search(search, 0, ids_.size());
+
+  std::vector<int> nearest(best.size());
+  for (auto it = nearest.rbegin(); it != nearest.rend(); ++it) {
+    *it = best.top().second;
+    best.pop();
+  }
+  return nearest;
+}
+
+std::tuple<bool, int> KdTree::NearestFeasible(const float x, const float y,
+                                              const float max_demand) const {
+  std::pair<double, int> best{std::numeric_limits<double>::max(), -1};
+  const auto search = [&](const auto &self, const int i) -> void {
+    if (i == -1 || min_demand_[i] > max_demand) {
+      return;
+    }
+    if (!erased_[i] && demand_[i] <= max_demand) {
+      best = std::min(best, std::pair<double, int>{Distance2(x, y, i), ids_[i]});
+    }
+    const double diff = (axis_[i] == 0) ? x - x_[i] : y - y_[i];
+    const int near = diff < 0 ? left_[i] : right_[i];
+    const int far = diff < 0 ? right_[i] : left_[i];
+    self(self, near);
+    if (diff * diff <= best.first) {
+      self(self, far);
+    }
+  };
+  if (!ids_.empty()) {
+    search(search, ids_.size() / 2);
+  }
+  return {best.second != -1, best.second};
+}
@@ -0,0 +1,436 @@
+/**
+ * @file large_neighborhood_search.cpp
+ * @author vss2sn
+ * @brief Contains the LNSSolution (Large Neighborhood Search Solution) class
+ */
+
+#include "cvrp/large_neighborhood_search.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <tuple>
+
+#include "cvrp/neighbor_lists.hpp"
+#include "cvrp/route.hpp"
+
+namespace {
+
+enum class RuinType { RANDOM, RADIAL, STRING };
+
+/**
+ * @brief struct Insertion
+ * @details Insertion of a customer after position after_ of route route_
+ */
+template <typename Cost>
+struct Insertion {
+ public:
+  int route_ = -1;
+  int after_ = -1;
+  Cost delta_ = std::numeric_limits<Cost>::max();
+};
+
+/**
+ * @brief struct Removal
+ * @details Customer removed from a route, and the position after which it was
+ * placed, so that the removal can be undone
+ */
+struct Removal {
+ public:
+  int node_;
+  int route_;
+  int after_;
+};
+
+}  // namespace
+
+LNSSolution::LNSSolution(const std::vector<Node>& nodes,
+                         const std::vector<Vehicle>& vehicles,
+                         const std::vector<std::vector<double>>& distanceMatrix,
+                         const LNSParameters& params)
+    : Solution(nodes, vehicles, distanceMatrix), params_(params) {
+  CreateInitialSolution();
+}
+
+LNSSolution::LNSSolution(const Problem& p, const LNSParameters& params)
+    : Solution(p), params_(params) {
+  CreateInitialSolution();
+}
+
+LNSSolution::LNSSolution(const Solution& s, const LNSParameters& params)
+    : Solution(s), params_(params) {
+  if (!s.CheckSolutionValid()) {
+    std::cout << "The input solution is invalid. Exiting." << '\n';
+    exit(0);
+  }
+}
+
+void LNSSolution::Solve() {
+  switch (cost_type_) {
+    case CostType::FLOAT:
+      Search<float>();
+      break;
+    case CostType::ROUNDED:
+      Search<int32_t>();
+      break;
+    default:
+      Search<double>();
+      break;
+  }
+  if (!verbose_) {
+    return;
+  }
+  for (const auto& i : nodes_) {
+    if (!i.is_routed_) {
+      std::cout << "Unreached node: " << '\n';
+      std::cout << OriginalNode(i) << '\n';
+    }
+  }
+  std::cout << "\n";
+  PrintSolution("route");
+}
+
+bool LNSSolution::Step(const double seconds) {
+  const double cost = TotalCost();
+  const auto params = params_;
+  const bool verbose = verbose_;
+  params_.iteration_budget_ = 0;
+  params_.time_budget_ = seconds;
+  verbose_ = false;
+  Solve();
+  params_ = params;
+  verbose_ = verbose;
+  if (TotalCost() < cost) {
+    ReportIncumbent();
+  }
+  return true;
+}
+
+template <typename Cost>
+void LNSSolution::Search() {
+  const CostMatrix<Cost> costs(*distanceMatrix_);
+  const auto& neighbors = *neighbors_;
+  RouteSet<Cost> routes(vehicles_, nodes_, costs);
+  const int n_routes = routes.Size();
+
+  std::vector<int> customers;
+  for (size_t u = 0; u < nodes_.size(); u++) {
+    if (routes.RouteOf(u) >= 0) {
+      customers.push_back(u);
+    }
+  }
+  if (customers.empty()) {
+    return;
+  }
+  const int max_removed = std::min<int>(
+      std::max(1, params_.max_removed_), customers.size());
+  const int min_removed =
+      std::min(std::max(1, params_.min_removed_), max_removed);
+  const int regret_k = std::max(1, params_.regret_k_);
+
+  std::default_random_engine rng(rand());
+  std::uniform_int_distribution<size_t> pick_customer(0, customers.size() - 1);
+  std::uniform_int_distribution<int> pick_n_removed(min_removed, max_removed);
+  std::uniform_int_distribution<int> pick_ruin(0, 2);
+
+  Cost current = 0;
+  for (int k = 0; k < n_routes; k++) {
+    current += routes[k].Distance();
+  }
+
+  // Routes that hold no customers; entries are checked when they are used
+  std::vector<int> empty_routes;
+  std::vector<char> listed(n_routes, 0);
+  const auto list_if_empty = [&](const int k) {
+    if (routes[k].Size() == 2 && listed[k] == 0) {
+      listed[k] = 1;
+      empty_routes.push_back(k);
+    }
+  };
+  const auto empty_route = [&]() {
+    while (!empty_routes.empty() && routes[empty_routes.back()].Size() != 2) {
+      listed[empty_routes.back()] = 0;
+      empty_routes.pop_back();
+    }
+    return empty_routes.empty() ? -1 : empty_routes.back();
+  };
+  for (int k = 0; k < n_routes; k++) {
+    list_if_empty(k);
+  }
+
+  std::vector<Removal> removed;
+  std::vector<int> inserted;
+
+  const auto remove = [&](const int u) {
+    const int k = routes.RouteOf(u);
+    if (k < 0) {
+      return;
+    }
+    const auto& route = routes[k];
+    const int p = routes.PositionOf(u);
+    current += costs(route[p - 1], route[p + 1]) - costs(route[p - 1], u) -
+               costs(u, route[p + 1]);
+    removed.push_back({u, k, p - 1});
+    routes.Remove(u);
+    list_if_empty(k);
+  };
+
+  const auto ruin = [&]() {
+    const int n_removed = pick_n_removed(rng);
+    const int seed = customers[pick_customer(rng)];
+    switch (static_cast<RuinType>(pick_ruin(rng))) {
+      case RuinType::RANDOM: {
+        for (int attempt = 0;
+             attempt < 4 * n_removed &&
+             static_cast<int>(removed.size()) < n_removed;
+             attempt++) {
+          remove(customers[pick_customer(rng)]);
+        }
+        break;
+      }
+      case RuinType::RADIAL: {
+        remove(seed);
+        for (const int w : neighbors.Of(seed)) {
+          if (static_cast<int>(removed.size()) >= n_removed) {
+            break;
+          }
+          remove(w);
+        }
+        break;
+      }
+      default: {
+        // A string of consecutive customers containing the seed or one of its
+        // neighbors is removed from each of their routes
+        std::vector<int> ruined;
+        const auto remove_string = [&](const int w) {
+          const int k = routes.RouteOf(w);
+          if (k < 0 ||
+              std::find(std::begin(ruined), std::end(ruined), k) !=
+                  std::end(ruined)) {
+            return;
+          }
+          ruined.push_back(k);
+          const int size = routes[k].Size();
+          const int p = routes.PositionOf(w);
+          const int max_length = std::min(
+              {std::max(1, params_.max_string_length_), size - 2,
+               n_removed - static_cast<int>(removed.size())});
+          const int length =
+              std::uniform_int_distribution<int>(1, max_length)(rng);
+          const int start = std::uniform_int_distribution<int>(
+              std::max(1, p - length + 1), std::min(p, size - 1 - length))(rng);
+          for (int pos = start + length - 1; pos >= start; pos--) {
+            remove(routes[k][pos]);
+          }
+        };
+        remove_string(seed);
+        for (const int w : neighbors.Of(seed)) {
+          if (static_cast<int>(removed.size()) >= n_removed) {
+            break;
+          }
+          remove_string(w);
+        }
+        break;
+      }
+    }
+  };
+
+  // Best insertion of a customer into a route, next to one of its neighbors
+  const auto best_insertion = [&](const int u, const int k) {
+    Insertion<Cost> best;
+    const auto& route = routes[k];
+    if (route.Load() + nodes_[u].demand_ > capacity_) {
+      return best;
+    }
+    for (const int w : neighbors.Of(u)) {
+      if (routes.RouteOf(w) != k) {
+        continue;
+      }
+      const int q = routes.PositionOf(w);
+      for (int after = q - 1; after <= q; after++) {
+        const Cost delta = costs(route[after], u) + costs(u, route[after + 1]) -
+                           costs(route[after], route[after + 1]);
+        if (delta < best.delta_) {
+          best = {k, after, delta};
+        }
+      }
+    }
+    return best;
+  };
+
+  // Cached insertions of every pending customer, at most one per route
+  std::vector<int> pending;
+  std::vector<std::vector<Insertion<Cost>>> options;
+  const auto update = [&](const int i, const int k) {
+    auto& o = options[i];
+    o.erase(std::remove_if(std::begin(o), std::end(o),
+                           [k](const Insertion<Cost>& ins) {
+                             return ins.route_ == k;
+                           }),
+            std::end(o));
+    const auto ins = best_insertion(pending[i], k);
+    if (ins.route_ >= 0) {
+      o.push_back(ins);
+    }
+  };
+  const auto build = [&](const int i) {
+    options[i].clear();
+    for (const int w : neighbors.Of(pending[i])) {
+      const int k = routes.RouteOf(w);
+      if (k >= 0 && std::none_of(std::begin(options[i]), std::end(options[i]),
+                                 [k](const Insertion<Cost>& ins) {
+                                   return ins.route_ == k;
+                                 })) {
+        update(i, k);
+      }
+    }
+  };
+  // Used when a customer cannot be placed next to any of its neighbors
+  const auto scan_all = [&](const int i) {
+    const int u = pending[i];
+    for (int k = 0; k < n_routes; k++) {
+      const auto& route = routes[k];
+      if (route.Size() == 2 || route.Load() + nodes_[u].demand_ > capacity_) {
+        continue;
+      }
+      Insertion<Cost> best;
+      for (int after = 0; after + 1 < route.Size(); after++) {
+        const Cost delta = costs(route[after], u) + costs(u, route[after + 1]) -
+                           costs(route[after], route[after + 1]);
+        if (delta < best.delta_) {
+          best = {k, after, delta};
+        }
+      }
+      options[i].push_back(best);
+    }
+  };
+
+  // Inserts the pending customers in order of decreasing regret; false if a
+  // customer cannot be inserted
+  std::vector<Cost> deltas;
+  const auto recreate = [&]() {
+    pending.clear();
+    for (const auto& r : removed) {
+      pending.push_back(r.node_);
+    }
+    options.resize(pending.size());
+    for (size_t i = 0; i < pending.size(); i++) {
+      build(i);
+    }
+    while (!pending.empty()) {
+      const int open = empty_route();
+      int chosen = -1;
+      Insertion<Cost> chosen_insertion;
+      // Fewer options first, then larger regret, then cheaper insertion
+      std::tuple<int, double, Cost> chosen_key;
+      for (size_t i = 0; i < pending.size(); i++) {
+        if (options[i].empty() && open < 0) {
+          scan_all(i);
+        }
+        const int u = pending[i];
+        deltas.clear();
+        Insertion<Cost> best;
+        for (const auto& ins : options[i]) {
+          deltas.push_back(ins.delta_);
+          if (ins.delta_ < best.delta_) {
+            best = ins;
+          }
+        }
+        if (open >= 0) {
+          const Cost delta = costs(0, u) + costs(u, 0);
+          deltas.push_back(delta);
+          if (delta < best.delta_) {
+            best = {open, 0, delta};
+          }
+        }
+        if (deltas.empty()) {
+          return false;
+        }
+        const int n_options = std::min<int>(deltas.size(), regret_k);
+        std::partial_sort(std::begin(deltas), std::begin(deltas) + n_options,
+                          std::end(deltas));
+        double regret = 0;
+        for (int j = 1; j < n_options; j++) {
+          regret += static_cast<double>(deltas[j] - deltas[0]);
+        }
+        const std::tuple<int, double, Cost> key{n_options, -regret,
+                                                best.delta_};
+        if (chosen < 0 || key < chosen_key) {
+          chosen = i;
+          chosen_key = key;
+          chosen_insertion = best;
+        }
+      }
+
+      const int u = pending[chosen];
+      const int k = chosen_insertion.route_;
+      routes.Insert(u, k, chosen_insertion.after_);
+      current += chosen_insertion.delta_;
+      inserted.push_back(u);
+      pending[chosen] = pending.back();
+      pending.pop_back();
+      std::swap(options[chosen], options.back());
+      options.pop_back();
+      for (size_t i = 0; i < pending.size(); i++) {
+        update(i, k);
+      }
+    }
+    return true;
+  };
+
+  const auto undo = [&]() {
+    for (const int u : inserted) {
+      const int k = routes.RouteOf(u);
+      routes.Remove(u);
+      list_if_empty(k);
+    }
+    for (auto it = removed.rbegin(); it != removed.rend(); ++it) {
+      routes.Insert(it->node_, it->route_, it->after_);
+    }
+  };
+
+  long long iteration_budget = params_.iteration_budget_;
+  if (iteration_budget <= 0 && params_.time_budget_ <= 0) {
+    iteration_budget = LNSParameters().iteration_budget_;
+  }
+
+  Cost best = current;
+  RouteSet<Cost> best_routes = routes;
+  const auto start = std::chrono::steady_clock::now();
+  for (long long iteration = 0;; iteration++) {
+    double progress = 0;
+    if (iteration_budget > 0) {
+      progress = static_cast<double>(iteration) / iteration_budget;
+    }
+    if (params_.time_budget_ > 0) {
+      const std::chrono::duration<double> elapsed =
+          std::chrono::steady_clock::now() - start;
+      progress = std::max(progress, elapsed.count() / params_.time_budget_);
+    }
+    if (progress >= 1) {
+      break;
+    }
+
+    const Cost previous = current;
+    removed.clear();
+    inserted.clear();
+    ruin();
+    const bool complete = recreate();
+    const double threshold =
+        static_cast<double>(best) * params_.threshold_ * (1 - progress);
+    if (!complete || (current > previous &&
+                      static_cast<double>(current - best) > threshold)) {
+      undo();
+      current = previous;
+      continue;
+    }
+    if (current < best) {
+      best = current;
+      best_routes = routes;
+    }
+  }
+  best_routes.WriteBack(vehicles_, *distanceMatrix_, capacity_);
+}
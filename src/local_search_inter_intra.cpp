@@ -7,11 +7,73 @@
 
 #include "cvrp/local_search_inter_intra.hpp"
 
+#include <algorithm>
+#include <cstdint>
+#include <functional>
 #include <iostream>
 #include <limits>
 #include <numeric>
+#include <queue>
+#include <utility>
+#include <vector>
 
-constexpr double margin_of_error = 0.00001;
+#include "cvrp/neighbor_lists.hpp"
+#include "cvrp/route.hpp"
+#include "cvrp/thread_pool.hpp"
+
+namespace {
+
+/**
+ * @brief Neighborhoods of the variable neighborhood descent, in the order in
+ * which they are explored
+ * @details RELOCATE moves a node to any position next to one of its neighbors.
+ * TWO_OPT_STAR exchanges the tails of two routes, SWAP exchanges two nodes of
+ * different routes, OR_OPT moves a segment of two or three nodes to another
+ * route and CROSS exchanges segments of up to three nodes between two routes
+ */
+enum class Neighborhood { RELOCATE, TWO_OPT_STAR, SWAP, OR_OPT, CROSS };
+
+constexpr int n_neighborhoods = 5;
+
+// Smallest number of nodes to be evaluated for which the evaluation is split
+// across the thread pool
+constexpr size_t min_parallel_nodes = 256;
+
+/**
+ * @brief struct Move
+ * @details For a relocation, move of node_ to the position after after_. For
+ * the other neighborhoods, exchange of the segment (i1_, j1_] of the route of
+ * node_ with the segment (i2_, j2_] of another route
+ */
+template <typename Cost>
+struct Move {
+ public:
+  Cost delta_ = std::numeric_limits<Cost>::max();
+  int node_ = -1;
+  int i1_ = -1;
+  int j1_ = -1;
+  int i2_ = -1;
+  int j2_ = -1;
+};
+
+/**
+ * @brief struct MoveCache
+ * @details Best move of a neighborhood between every pair of routes, the
+ * improving ones ordered by cost, and the don't look bits of the nodes
+ */
+template <typename Cost>
+struct MoveCache {
+ public:
+  using Entry = std::pair<Cost, int>;
+  std::vector<Move<Cost>> moves_;
+  std::vector<int> touched_;
+  std::vector<char> is_touched_;
+  std::priority_queue<Entry, std::vector<Entry>, std::greater<>> best_moves_;
+  std::vector<char> look_;
+  std::vector<int> to_look_;
+};
+
+}  // namespace
 
 LocalSearchInterIntraSolution::LocalSearchInterIntraSolution(
     const std::vector<Node> &nodes, const std::vector<Vehicle> &vehicles,
@@ -21,7 +83,7 @@ LocalSearchInterIntraSolution::LocalSearchInterIntraSolution(
 }
 
 LocalSearchInterIntraSolution::LocalSearchInterIntraSolution(const Problem &p)
-    : Solution(p.nodes_, p.vehicles_, p.distanceMatrix_) {
+    : Solution(p) {
   CreateInitialSolution();
 }
 
@@ -34,68 +96,291 @@ LocalSearchInterIntraSolution::LocalSearchInterIntraSolution(const Solution &s)
 }
 
 void LocalSearchInterIntraSolution::Solve() {
-  while (true) {
-    int best_c = -1;
-    int best_r = -1;
-    Vehicle *v_temp_2 = nullptr;
-    Vehicle *v_temp = nullptr;
-    double delta = std::numeric_limits<double>::max();
-    for (auto &v : vehicles_) {
-      for (size_t cur = 1; cur < v.nodes_.size() - 1; cur++) {
-        const int v_cur = v.nodes_[cur];
-        const int v_prev = v.nodes_[cur - 1];
-        const int v_next_c = v.nodes_[cur + 1];
-        const double cost_reduction = distanceMatrix_[v_prev][v_next_c] -
-                                      distanceMatrix_[v_prev][v_cur] -
-                                      distanceMatrix_[v_cur][v_next_c];
-        for (auto &v2 : vehicles_) {
-          for (size_t rep = 0; rep < v2.nodes_.size() - 1; rep++) {
-            const int v_rep = v2.nodes_[rep];
-            const int v_next_r = v2.nodes_[rep + 1];
-            if (v_rep != v_cur && (v.id_ != v2.id_ || v_rep != v_prev)) {
-              const double cost_increase = distanceMatrix_[v_rep][v_cur] +
-                                           distanceMatrix_[v_cur][v_next_r] -
-                                           distanceMatrix_[v_rep][v_next_r];
-              if (cost_increase + cost_reduction < delta &&
-                  (v2.load_ - nodes_[v_cur].demand_ >= 0 || v.id_ == v2.id_)) {
-                delta = cost_increase + cost_reduction;
-                best_c = cur;
-                best_r = rep;
-                v_temp_2 = &v2;
-                v_temp = &v;
-              }
-            }
-          }
-        }
-      }
-    }
-    if (delta > -margin_of_error || v_temp == nullptr || v_temp_2 == nullptr) {
+  switch (cost_type_) {
+    case CostType::FLOAT:
+      Improve<float>();
+      break;
+    case CostType::ROUNDED:
+      Improve<int32_t>();
+      break;
+    default:
+      Improve<double>();
       break;
-    }
-    int val_best_c = *(v_temp->nodes_.begin() + best_c);
-    v_temp->nodes_.erase(v_temp->nodes_.begin() + best_c);
-    v_temp->CalculateCost(distanceMatrix_);
-    if (v_temp->id_ == v_temp_2->id_ && best_c < best_r) {
-      v_temp_2->nodes_.insert(std::next(v_temp_2->nodes_.begin(), best_r),
-                              val_best_c);
-    } else {
-      v_temp_2->nodes_.insert(std::next(v_temp_2->nodes_.begin(), best_r + 1),
-                              val_best_c);
-    }
-    v_temp_2->CalculateCost(distanceMatrix_);
-    v_temp->load_ += nodes_[val_best_c].demand_;
-    v_temp_2->load_ -= nodes_[val_best_c].demand_;
   }
   double cost = std::accumulate(
       std::begin(vehicles_), std::end(vehicles_), 0.0,
       [](const double sum, const Vehicle &v) { return sum + v.cost_; });
 
+  if (!verbose_) {
+    return;
+  }
   for (const auto &i : nodes_) {
     if (!i.is_routed_) {
       std::cout << "Unreached node: " << '\n';
-      std::cout << i << '\n';
+      std::cout << OriginalNode(i) << '\n';
     }
   }
   std::cout << "\n";
   PrintSolution("route");
 }
+
+template <typename Cost>
+void LocalSearchInterIntraSolution::Improve() {
+  const CostMatrix<Cost> costs(*distanceMatrix_);
+  const auto &neighbors = *neighbors_;
+  RouteSet<Cost> routes(vehicles_, nodes_, costs);
+  const int n_routes = routes.Size();
+
+  // Nodes that have a given node in their neighbor list
+  std::vector<std::vector<int>> reverse_neighbors(nodes_.size());
+  for (size_t u = 0; u < nodes_.size(); u++) {
+    if (routes.RouteOf(u) >= 0) {
+      for (const int w : neighbors.Of(u)) {
+        reverse_neighbors[w].push_back(u);
+      }
+    }
+  }
+
+  // Best move from route r1 into route r2 is stored at r1 * n_routes + r2
+  std::vector<MoveCache<Cost>> caches(n_neighborhoods);
+  for (auto &cache : caches) {
+    cache.moves_.resize(n_routes * n_routes);
+    cache.is_touched_.resize(n_routes * n_routes, 0);
+    cache.look_.resize(nodes_.size(), 0);
+  }
+
+  // Don't look bits: only nodes whose bit is cleared are evaluated again
+  const auto wake = [&](const int u) {
+    if (routes.RouteOf(u) < 0) {
+      return;
+    }
+    for (auto &cache : caches) {
+      if (cache.look_[u] == 0) {
+        cache.look_[u] = 1;
+        cache.to_look_.push_back(u);
+      }
+    }
+  };
+  for (size_t u = 0; u < nodes_.size(); u++) {
+    wake(u);
+  }
+
+  // The moves from a route are only written while evaluating its nodes
+  const auto offer = [&](MoveCache<Cost> &cache, std::vector<int> &touched,
+                         const int p, const Move<Cost> &move) {
+    auto &m = cache.moves_[p];
+    if (move.delta_ < m.delta_) {
+      m = move;
+      if (cache.is_touched_[p] == 0) {
+        cache.is_touched_[p] = 1;
+        touched.push_back(p);
+      }
+    }
+  };
+
+  const auto relocate = [&](MoveCache<Cost> &cache, std::vector<int> &touched,
+                            const int u) {
+    const int r1 = routes.RouteOf(u);
+    const auto &v = routes[r1];
+    const int cur = routes.PositionOf(u);
+    const int v_prev = v[cur - 1];
+    const int v_next_c = v[cur + 1];
+    const Cost cost_reduction =
+        costs(v_prev, v_next_c) - costs(v_prev, u) - costs(u, v_next_c);
+    for (const int w : neighbors.Of(u)) {
+      const int r2 = routes.RouteOf(w);
+      if (r2 < 0 ||
+          (r1 != r2 && routes[r2].Load() + nodes_[u].demand_ > capacity_)) {
+        continue;
+      }
+      const auto &v2 = routes[r2];
+      // Insert either before or after the neighbor
+      for (int rep = routes.PositionOf(w) - 1; rep <= routes.PositionOf(w);
+           rep++) {
+        const int v_rep = v2[rep];
+        const int v_next_r = v2[rep + 1];
+        if (v_rep == u || v_next_r == u) {
+          continue;
+        }
+        const Cost cost_increase =
+            costs(v_rep, u) + costs(u, v_next_r) - costs(v_rep, v_next_r);
+        offer(cache, touched, r1 * n_routes + r2,
+              {cost_increase + cost_reduction, u, -1, -1, rep, rep});
+      }
+    }
+  };
+
+  const auto exchange = [&](MoveCache<Cost> &cache, std::vector<int> &touched,
+                            const int u, const int r1, const int i1,
+                            const int j1, const int r2, const int i2,
+                            const int j2) {
+    const auto &a = routes[r1];
+    const auto &b = routes[r2];
+    if (i1 < 0 || i2 < 0 || j1 > a.Size() - 2 || j2 > b.Size() - 2 ||
+        (i1 == j1 && i2 == j2)) {
+      return;
+    }
+    const int load_1 = a.Load(i1, j1);
+    const int load_2 = b.Load(i2, j2);
+    if (a.Load() - load_1 + load_2 > capacity_ ||
+        b.Load() - load_2 + load_1 > capacity_) {
+      return;
+    }
+    const Cost delta = routes.ExchangeDelta(r1, i1, j1, r2, i2, j2);
+    offer(cache, touched, r1 * n_routes + r2, {delta, u, i1, j1, i2, j2});
+  };
+
+  // Every move places the node next to one of its neighbors in another route
+  const auto evaluate = [&](const Neighborhood neighborhood,
+                            MoveCache<Cost> &cache, std::vector<int> &touched,
+                            const int u) {
+    if (neighborhood == Neighborhood::RELOCATE) {
+      relocate(cache, touched, u);
+      return;
+    }
+    int la_min = 1;
+    int la_max = 3;
+    int lb_min = 1;
+    int lb_max = 3;
+    if (neighborhood == Neighborhood::SWAP) {
+      la_max = 1;
+      lb_max = 1;
+    } else if (neighborhood == Neighborhood::OR_OPT) {
+      la_min = 2;
+      lb_min = 0;
+      lb_max = 0;
+    }
+    const int r1 = routes.RouteOf(u);
+    const int p = routes.PositionOf(u);
+    const int end_1 = routes[r1].Size() - 2;
+    for (const int w : neighbors.Of(u)) {
+      const int r2 = routes.RouteOf(w);
+      if (r2 < 0 || r2 == r1) {
+        continue;
+      }
+      const int q = routes.PositionOf(w);
+      if (neighborhood == Neighborhood::TWO_OPT_STAR) {
+        const int end_2 = routes[r2].Size() - 2;
+        exchange(cache, touched, u, r1, p, end_1, r2, q - 1, end_2);
+        exchange(cache, touched, u, r1, p - 1, end_1, r2, q, end_2);
+        continue;
+      }
+      for (int la = la_min; la <= la_max; la++) {
+        for (int lb = lb_min; lb <= lb_max; lb++) {
+          // Segment starting with the node placed after the neighbor, or
+          // ending with the node placed before it
+          exchange(cache, touched, u, r1, p - 1, p - 1 + la, r2, q, q + lb);
+          exchange(cache, touched, u, r1, p - la, p, r2, q - 1 - lb, q - 1);
+        }
+      }
+    }
+  };
+
+  // Nodes to be evaluated grouped by route, keeping the order in which they
+  // were woken. Each route is evaluated by a single task, so the best move
+  // of every route pair is chosen exactly as when evaluating serially.
+  auto &pool = DefaultThreadPool();
+  std::vector<int> group_start(n_routes + 1);
+  std::vector<int> grouped;
+  std::vector<int> active;
+  std::vector<std::vector<int>> touched_by(n_routes);
+  const auto evaluate_all = [&](const Neighborhood neighborhood,
+                                MoveCache<Cost> &cache) {
+    if (pool.Size() == 1 || cache.to_look_.size() < min_parallel_nodes) {
+      for (const int u : cache.to_look_) {
+        evaluate(neighborhood, cache, cache.touched_, u);
+        cache.look_[u] = 0;
+      }
+      return;
+    }
+    std::fill(std::begin(group_start), std::end(group_start), 0);
+    for (const int u : cache.to_look_) {
+      group_start[routes.RouteOf(u) + 1]++;
+    }
+    active.clear();
+    for (int r = 0; r < n_routes; r++) {
+      if (group_start[r + 1] > 0) {
+        active.push_back(r);
+      }
+      group_start[r + 1] += group_start[r];
+    }
+    grouped.resize(cache.to_look_.size());
+    std::vector<int> next(std::begin(group_start), std::end(group_start) - 1);
+    for (const int u : cache.to_look_) {
+      grouped[next[routes.RouteOf(u)]++] = u;
+    }
+    pool.ParallelFor(active.size(), [&](const int i) {
+      const int r = active[i];
+      for (int j = group_start[r]; j < group_start[r + 1]; j++) {
+        evaluate(neighborhood, cache, touched_by[r], grouped[j]);
+        cache.look_[grouped[j]] = 0;
+      }
+    });
+    for (const int r : active) {
+      cache.touched_.insert(std::end(cache.touched_),
+                            std::begin(touched_by[r]), std::end(touched_by[r]));
+      touched_by[r].clear();
+    }
+  };
+
+  int level = 0;
+  while (level < n_neighborhoods) {
+    const auto neighborhood = static_cast<Neighborhood>(level);
+    auto &cache = caches[level];
+    evaluate_all(neighborhood, cache);
+    cache.to_look_.clear();
+    for (const int p : cache.touched_) {
+      cache.is_touched_[p] = 0;
+      if (IsImprovement(cache.moves_[p].delta_)) {
+        cache.best_moves_.emplace(cache.moves_[p].delta_, p);
+      }
+    }
+    cache.touched_.clear();
+
+    // Entries are stale if the move of the route pair has changed since
+    int best = -1;
+    while (!cache.best_moves_.empty()) {
+      const auto [delta, p] = cache.best_moves_.top();
+      cache.best_moves_.pop();
+      if (cache.moves_[p].node_ >= 0 && cache.moves_[p].delta_ == delta) {
+        best = p;
+        break;
+      }
+    }
+    // Move on to the next neighborhood once this one has no improving move
+    if (best < 0) {
+      level++;
+      continue;
+    }
+
+    const int r1 = best / n_routes;
+    const int r2 = best % n_routes;
+    const auto &m = cache.moves_[best];
+    if (neighborhood == Neighborhood::RELOCATE) {
+      routes.Relocate(m.node_, r2, m.i2_);
+    } else {
+      routes.Exchange(r1, m.i1_, m.j1_, r2, m.i2_, m.j2_);
+    }
+
+    // Only the moves from and into the two routes are affected
+    for (auto &c : caches) {
+      for (const int r : {r1, r2}) {
+        for (int k = 0; k < n_routes; k++) {
+          c.moves_[r * n_routes + k] = {};
+          c.moves_[k * n_routes + r] = {};
+        }
+      }
+    }
+    for (const int r : {r1, r2}) {
+      const auto &route = routes[r];
+      for (int pos = 1; pos + 1 < route.Size(); pos++) {
+        wake(route[pos]);
+        for (const int u : reverse_neighbors[route[pos]]) {
+          wake(u);
+        }
+      }
+    }
+    level = 0;
+  }
+  routes.WriteBack(vehicles_, *distanceMatrix_, capacity_);
+}
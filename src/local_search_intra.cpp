@@ -7,10 +7,11 @@
 
 #include "cvrp/local_search_intra.hpp"
 
+#include <cstdint>
 #include <iostream>
 #include <numeric>
 
-constexpr double margin_of_error = 0.00001;
+#include "cvrp/route.hpp"
 
 LocalSearchIntraSolution::LocalSearchIntraSolution(
     const std::vector<Node>& nodes, const std::vector<Vehicle>& vehicles,
@@ -20,7 +21,7 @@ LocalSearchIntraSolution::LocalSearchIntraSolution(
 }
 
 LocalSearchIntraSolution::LocalSearchIntraSolution(const Problem& p)
-    : Solution(p.nodes_, p.vehicles_, p.distanceMatrix_) {
+    : Solution(p) {
   CreateInitialSolution();
 }
 
@@ -33,25 +34,56 @@ LocalSearchIntraSolution::LocalSearchIntraSolution(const Solution& s)
 }
 
 void LocalSearchIntraSolution::Solve() {
+  switch (cost_type_) {
+    case CostType::FLOAT:
+      Improve<float>();
+      break;
+    case CostType::ROUNDED:
+      Improve<int32_t>();
+      break;
+    default:
+      Improve<double>();
+      break;
+  }
+  double cost = std::accumulate(
+      std::begin(vehicles_), std::end(vehicles_), 0.0,
+      [](const double sum, const Vehicle& v) { return sum + v.cost_; });
+  if (!verbose_) {
+    return;
+  }
+  for (const auto& i : nodes_) {
+    if (!i.is_routed_) {
+      std::cout << "Unreached node: " << '\n';
+      std::cout << OriginalNode(i) << '\n';
+    }
+  }
+  std::cout << "\n";
+  PrintSolution("route");
+}
+
+template <typename Cost>
+void LocalSearchIntraSolution::Improve() {
+  const CostMatrix<Cost> costs(*distanceMatrix_);
   for (auto& v : vehicles_) {
+    Route<Cost> route(v.nodes_, nodes_, costs);
     while (true) {
-      double delta = 0;
+      Cost delta = 0;
       int best_c = -1;
       int best_r = -1;
-      for (size_t cur = 1; cur < v.nodes_.size() - 1; cur++) {
-        const int v_cur = v.nodes_[cur];
-        const int v_prev = v.nodes_[cur - 1];
-        const int v_next_c = v.nodes_[cur + 1];
-        const double cost_reduction = distanceMatrix_[v_prev][v_next_c] -
-                                      distanceMatrix_[v_prev][v_cur] -
-                                      distanceMatrix_[v_cur][v_next_c];
-        for (size_t rep = 1; rep < v.nodes_.size() - 1; rep++) {
+      for (int cur = 1; cur < route.Size() - 1; cur++) {
+        const int v_cur = route[cur];
+        const int v_prev = route[cur - 1];
+        const int v_next_c = route[cur + 1];
+        const Cost cost_reduction = costs(v_prev, v_next_c) -
+                                    costs(v_prev, v_cur) -
+                                    costs(v_cur, v_next_c);
+        for (int rep = 1; rep < route.Size() - 1; rep++) {
           if (rep != cur && rep != cur - 1) {
-            const int v_rep = v.nodes_[rep];
-            const int v_next_r = v.nodes_[rep + 1];
-            const double cost_increase = distanceMatrix_[v_rep][v_cur] +
-                                         distanceMatrix_[v_cur][v_next_r] -
-                                         distanceMatrix_[v_rep][v_next_r];
+            const int v_rep = route[rep];
+            const int v_next_r = route[rep + 1];
+            const Cost cost_increase = costs(v_rep, v_cur) +
+                                       costs(v_cur, v_next_r) -
+                                       costs(v_rep, v_next_r);
             if (cost_increase + cost_reduction < delta) {
               delta = cost_increase + cost_reduction;
               best_c = cur;
@@ -61,28 +93,18 @@ void LocalSearchIntraSolution::Solve() {
         }
       }
 
-      if (delta > -margin_of_error) {
+      if (!IsImprovement(delta)) {
         break;
       }
-      const int val_best_c = *std::next(v.nodes_.begin(), best_c);
-      v.nodes_.erase(std::next(v.nodes_.begin(), best_c));
+      const int val_best_c = route[best_c];
+      route.Erase(best_c);
       if (best_c < best_r) {
-        v.nodes_.insert(std::next(v.nodes_.begin(), best_r), val_best_c);
+        route.Insert(best_r, val_best_c);
       } else {
-        v.nodes_.insert(std::next(v.nodes_.begin(), best_r + 1), val_best_c);
+        route.Insert(best_r + 1, val_best_c);
       }
-      v.CalculateCost(distanceMatrix_);
-    }
-  }
-  double cost = std::accumulate(
-      std::begin(vehicles_), std::end(vehicles_), 0.0,
-      [](const double sum, const Vehicle& v) { return sum + v.cost_; });
-  for (const auto& i : nodes_) {
-    if (!i.is_routed_) {
-      std::cout << "Unreached node: " << '\n';
-      std::cout << i << '\n';
     }
+    v.nodes_ = route.Nodes();
+    v.CalculateCost(*distanceMatrix_);
   }
-  std::cout << "\n";
-  PrintSolution("route");
 }
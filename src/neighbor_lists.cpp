@@ -0,0 +1,32 @@
+/**
+ * @file neighbor_lists.cpp
+ * @author vss2sn
+ * @brief Contains the NeighborLists class holding the k nearest customers of
+ * every node, used to restrict searches to granular neighborhoods
+ */
+
+#include "cvrp/neighbor_lists.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+#include "cvrp/kd_tree.hpp"
+
+NeighborLists::NeighborLists(const std::vector<Node> &nodes, const size_t k)
+    : k_(std::min(k, nodes.size() < 2 ? 0 : nodes.size() - 2)),
+      neighbors_(nodes.size() * k_),
+      radius_(nodes.size(), 0) {
+  std::vector<int> customers(nodes.size() - 1);
+  std::iota(customers.begin(), customers.end(), 1);
+  const KdTree tree(nodes, std::move(customers));
+  for (size_t i = 0; i < nodes.size(); i++) {
+    const auto nearest = tree.Nearest(nodes[i].x_, nodes[i].y_, k_, i);
+    std::copy(nearest.begin(), nearest.end(), neighbors_.begin() + i * k_);
+    if (!nearest.empty()) {
+      const auto &n = nodes[nearest.back()];
+      radius_[i] = sqrt(pow((nodes[i].x_ - n.x_), 2) +
+                        pow((nodes[i].y_ - n.y_), 2));
+    }
+  }
+}
@@ -0,0 +1,84 @@
+/**
+ * @file pipeline.cpp
+ * @author vss2sn
+ * @brief Contains the Pipeline class, which chains solvers into a hybrid
+ */
+
+#include "cvrp/pipeline.hpp"
+
+#include <chrono>
+
+namespace {
+
+/**
+ * @brief class InitialSolution
+ * @details Greedy initial solution of a problem, used by the first stage that
+ * needs a solution if no stage before it produced one
+ */
+class InitialSolution : public Solution {
+ public:
+  explicit InitialSolution(const Problem& p) : Solution(p) {
+    CreateInitialSolution();
+  }
+
+  void Solve() override {}
+};
+
+}  // namespace
+
+Pipeline& Pipeline::Then(const std::string& name, const Stage& stage) {
+  stages_.push_back({name, stage, nullptr});
+  return *this;
+}
+
+PipelineResult Pipeline::Run() const {
+  PipelineResult result;
+  std::unique_ptr<Solution> current;
+  for (const auto& stage : stages_) {
+    const auto start = std::chrono::steady_clock::now();
+    const auto elapsed = [&start]() {
+      const std::chrono::duration<double> d =
+          std::chrono::steady_clock::now() - start;
+      return d.count();
+    };
+    StageReport report;
+    report.name_ = stage.name_;
+    std::unique_ptr<Solution> next;
+    if (stage.from_solution_) {
+      if (!current) {
+        current = std::make_unique<InitialSolution>(problem_);
+      }
+      if (!current->CheckSolutionValid()) {
+        report.seconds_ = elapsed();
+        result.stages_.push_back(report);
+        result.error_ = "The input of stage " + stage.name_ + " is invalid";
+        return result;
+      }
+      next = stage.from_solution_(*current);
+    } else {
+      next = stage.from_problem_();
+    }
+    if (!next) {
+      report.seconds_ = elapsed();
+      result.stages_.push_back(report);
+      result.error_ = "Stage " + stage.name_ + " did not create a solver";
+      return result;
+    }
+    next->SetVerbose(false);
+    next->Solve();
+
+    report.seconds_ = elapsed();
+    report.cost_ = next->TotalCost();
+    report.valid_ = next->CheckSolutionValid();
+    result.stages_.push_back(report);
+    if (!report.valid_) {
+      result.error_ = "Stage " + stage.name_ + " found an invalid solution";
+      return result;
+    }
+    current = std::move(next);
+    result.vehicles_ = current->GetVehicles();
+    result.cost_ = report.cost_;
+  }
+  result.ok_ = true;
+  return result;
+}
@@ -0,0 +1,229 @@
+/**
+ * @file portfolio.cpp
+ * @author vss2sn
+ * @brief Contains the PortfolioSolution class, which runs several solvers
+ * concurrently, and the IncumbentBoard they share
+ */
+
+#include "cvrp/portfolio.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <thread>
+#include <utility>
+
+#include "cvrp/genetic_algorithm.hpp"
+#include "cvrp/large_neighborhood_search.hpp"
+#include "cvrp/local_search_inter_intra.hpp"
+#include "cvrp/simulated_annealing.hpp"
+#include "cvrp/tabu_search.hpp"
+
+namespace {
+
+constexpr int n_chromosomes = 20;  // of the genetic algorithm members
+constexpr double min_run = 0.01;  // seconds, shortest run of a member
+constexpr auto stall_poll = std::chrono::milliseconds(10);
+
+/**
+ * @brief class StartingSolution
+ * @details Solution handed to the members of the portfolio: the problem of the
+ * portfolio with the routes to start from
+ */
+class StartingSolution : public Solution {
+ public:
+  StartingSolution(const Solution& s, const std::vector<Vehicle>& vehicles)
+      : Solution(s) {
+    vehicles_ = vehicles;
+  }
+
+  void Solve() override {}
+};
+
+}  // namespace
+
+IncumbentBoard::~IncumbentBoard() {
+  const Entry* entry = best_.load(std::memory_order_acquire);
+  while (entry != nullptr) {
+    const Entry* previous = entry->previous_;
+    delete entry;
+    entry = previous;
+  }
+}
+
+bool IncumbentBoard::Publish(const double cost,
+                             const std::vector<Vehicle>& vehicles,
+                             const std::string& solver) {
+  const Entry* best = best_.load(std::memory_order_acquire);
+  if (best != nullptr && best->cost_ <= cost) {
+    return false;
+  }
+  auto* entry = new Entry{cost, vehicles, solver, best};
+  while (!best_.compare_exchange_weak(entry->previous_, entry,
+                                      std::memory_order_acq_rel,
+                                      std::memory_order_acquire)) {
+    // Another solver published in the meantime; entry->previous_ now holds
+    // its solution
+    if (entry->previous_ != nullptr && entry->previous_->cost_ <= cost) {
+      delete entry;
+      return false;
+    }
+  }
+  return true;
+}
+
+PortfolioSolution::PortfolioSolution(
+    const std::vector<Node>& nodes, const std::vector<Vehicle>& vehicles,
+    const std::vector<std::vector<double>>& distanceMatrix,
+    const PortfolioParameters& params)
+    : Solution(nodes, vehicles, distanceMatrix), params_(params) {
+  CreateInitialSolution();
+}
+
+PortfolioSolution::PortfolioSolution(const Problem& p,
+                                     const PortfolioParameters& params)
+    : Solution(p), params_(params) {
+  CreateInitialSolution();
+}
+
+PortfolioSolution::PortfolioSolution(const Solution& s,
+                                     const PortfolioParameters& params)
+    : Solution(s), params_(params) {
+  if (!s.CheckSolutionValid()) {
+    std::cout << "The input solution is invalid. Exiting." << '\n';
+    exit(0);
+  }
+}
+
+void PortfolioSolution::AddMember(const std::string& name,
+                                  const Member& member) {
+  members_.emplace_back(name, member);
+}
+
+void PortfolioSolution::AddDefaultMembers() {
+  const auto ga = [](const bool penalty) {
+    return [penalty](const Solution& s, const double seconds) {
+      GASolution vrp_ga(s, n_chromosomes, std::numeric_limits<int>::max());
+      if (penalty) {
+        PenaltyParameters params;
+        params.enabled_ = true;
+        vrp_ga.SetPenalty(params);
+      }
+      vrp_ga.SetTimeBudget(seconds);
+      vrp_ga.SetVerbose(false);
+      vrp_ga.Solve();
+      return vrp_ga.GetVehicles();
+    };
+  };
+  AddMember("genetic algorithm", ga(false));
+  AddMember("genetic algorithm (penalty)", ga(true));
+  AddMember("local search", [](const Solution& s, const double /* seconds */) {
+    LocalSearchInterIntraSolution vrp_lsii(s);
+    vrp_lsii.SetVerbose(false);
+    vrp_lsii.Solve();
+    return vrp_lsii.GetVehicles();
+  });
+  AddMember("simulated annealing", [](const Solution& s, const double seconds) {
+    AnnealingParameters params;
+    params.move_budget_ = 0;
+    params.time_budget_ = seconds;
+    SimulatedAnnealingSolution vrp_sa(s, params);
+    vrp_sa.SetVerbose(false);
+    vrp_sa.Solve();
+    return vrp_sa.GetVehicles();
+  });
+  AddMember("tabu search", [](const Solution& s, const double seconds) {
+    TabuParameters params;
+    params.iteration_budget_ = 0;
+    params.time_budget_ = seconds;
+    TabuSearchSolution vrp_ts(s, params);
+    vrp_ts.SetVerbose(false);
+    vrp_ts.Solve();
+    return vrp_ts.GetVehicles();
+  });
+  AddMember("large neighborhood search",
+            [](const Solution& s, const double seconds) {
+              LNSParameters params;
+              params.iteration_budget_ = 0;
+              params.time_budget_ = seconds;
+              LNSSolution vrp_lns(s, params);
+              vrp_lns.SetVerbose(false);
+              vrp_lns.Solve();
+              return vrp_lns.GetVehicles();
+            });
+}
+
+void PortfolioSolution::Solve() {
+  if (!CheckSolutionValid()) {
+    std::cout << "The initial solution is invalid. Exiting." << '\n';
+    exit(0);
+  }
+  if (members_.empty()) {
+    AddDefaultMembers();
+  }
+  board_.Publish(TotalCost(), vehicles_, "initial solution");
+
+  const auto deadline =
+      std::chrono::steady_clock::now() +
+      std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+          std::chrono::duration<double>(params_.time_budget_));
+  std::vector<std::thread> workers;
+  workers.reserve(members_.size());
+  for (const auto& [name, member] : members_) {
+    workers.emplace_back([this, &name = name, &member = member, deadline]() {
+      Run(name, member, deadline);
+    });
+  }
+  for (auto& worker : workers) {
+    worker.join();
+  }
+  vehicles_ = board_.Best()->vehicles_;
+
+  if (!verbose_) {
+    return;
+  }
+  std::cout << "Best solution found by: " << board_.Best()->solver_ << '\n';
+  std::cout << "\n";
+  PrintSolution("route");
+}
+
+void PortfolioSolution::Run(
+    const std::string& name, const Member& member,
+    const std::chrono::steady_clock::time_point deadline) {
+  StartingSolution current(*this, vehicles_);
+  double current_cost = current.TotalCost();
+  bool stalled = false;
+  while (true) {
+    const auto now = std::chrono::steady_clock::now();
+    const std::chrono::duration<double> remaining = deadline - now;
+    if (remaining.count() < min_run) {
+      break;
+    }
+    const auto* best = board_.Best();
+    if (params_.pull_incumbent_ && best->cost_ < current_cost) {
+      current = StartingSolution(*this, best->vehicles_);
+      current_cost = best->cost_;
+      stalled = false;
+    }
+    if (stalled) {
+      if (!params_.pull_incumbent_) {
+        break;
+      }
+      std::this_thread::sleep_for(stall_poll);
+      continue;
+    }
+
+    const double slice = std::min(params_.slice_, remaining.count());
+    StartingSolution found(*this, member(current, slice));
+    const std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - now;
+    const double found_cost = found.TotalCost();
+    if (found.CheckSolutionValid() && found_cost < current_cost) {
+      board_.Publish(found_cost, found.GetVehicles(), name);
+      current = std::move(found);
+      current_cost = found_cost;
+    } else {
+      stalled = elapsed.count() < slice;
+    }
+  }
+}
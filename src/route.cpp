@@ -0,0 +1,192 @@
+/**
+ * @file route.cpp
+ * @author vss2sn
+ * @brief Contains the Route and RouteSet classes, array based routes with
+ * cumulative costs and loads used by the local searches
+ */
+
+#include "cvrp/route.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+
+template <typename Cost>
+Route<Cost>::Route(const std::vector<int> &nodes,
+                   const std::vector<Node> &all_nodes,
+                   const CostMatrix<Cost> &costs)
+    : all_nodes_(&all_nodes),
+      costs_(&costs),
+      nodes_(nodes),
+      distance_(nodes.size(), 0),
+      load_(nodes.size(), 0) {
+  Update(0);
+}
+
+template <typename Cost>
+void Route<Cost>::Erase(const int pos) {
+  nodes_.erase(std::next(nodes_.begin(), pos));
+  distance_.pop_back();
+  load_.pop_back();
+  Update(pos);
+}
+
+template <typename Cost>
+void Route<Cost>::Insert(const int pos, const int node) {
+  nodes_.insert(std::next(nodes_.begin(), pos), node);
+  distance_.push_back(0);
+  load_.push_back(0);
+  Update(pos);
+}
+
+template <typename Cost>
+void Route<Cost>::Replace(const int i, const int j,
+                          const std::vector<int> &segment) {
+  const int size = Size() - (j - i) + static_cast<int>(segment.size());
+  nodes_.erase(std::next(nodes_.begin(), i + 1),
+               std::next(nodes_.begin(), j + 1));
+  nodes_.insert(std::next(nodes_.begin(), i + 1), segment.begin(),
+                segment.end());
+  distance_.resize(size);
+  load_.resize(size);
+  Update(i + 1);
+}
+
+template <typename Cost>
+void Route<Cost>::Reverse(const int i, const int j) {
+  std::reverse(std::next(nodes_.begin(), i), std::next(nodes_.begin(), j + 1));
+  Update(i);
+}
+
+template <typename Cost>
+void Route<Cost>::Update(const int from) {
+  int p = std::max(from, 0);
+  if (p == 0 && !nodes_.empty()) {
+    distance_[0] = 0;
+    load_[0] = (*all_nodes_)[nodes_[0]].demand_;
+    p = 1;
+  }
+  for (; p < Size(); p++) {
+    distance_[p] = distance_[p - 1] + (*costs_)(nodes_[p - 1], nodes_[p]);
+    load_[p] = load_[p - 1] + (*all_nodes_)[nodes_[p]].demand_;
+  }
+}
+
+template <typename Cost>
+RouteSet<Cost>::RouteSet(const std::vector<Vehicle> &vehicles,
+                         const std::vector<Node> &nodes,
+                         const CostMatrix<Cost> &costs)
+    : costs_(&costs), route_of_(nodes.size(), -1), pos_of_(nodes.size(), -1) {
+  routes_.reserve(vehicles.size());
+  for (const auto &v : vehicles) {
+    routes_.emplace_back(v.nodes_, nodes, costs);
+  }
+  for (int k = 0; k < Size(); k++) {
+    Locate(k, 0);
+  }
+}
+
+template <typename Cost>
+void RouteSet<Cost>::Relocate(const int node, const int k, const int after) {
+  const int from = route_of_[node];
+  const int pos = pos_of_[node];
+  routes_[from].Erase(pos);
+  if (from == k && pos < after) {
+    routes_[k].Insert(after, node);
+    Locate(k, pos);
+  } else {
+    routes_[k].Insert(after + 1, node);
+    if (from == k) {
+      Locate(k, after + 1);
+    } else {
+      Locate(from, pos);
+      Locate(k, after + 1);
+    }
+  }
+}
+
+template <typename Cost>
+void RouteSet<Cost>::Remove(const int node) {
+  const int k = route_of_[node];
+  const int pos = pos_of_[node];
+  routes_[k].Erase(pos);
+  route_of_[node] = -1;
+  pos_of_[node] = -1;
+  Locate(k, pos);
+}
+
+template <typename Cost>
+void RouteSet<Cost>::Insert(const int node, const int k, const int after) {
+  routes_[k].Insert(after + 1, node);
+  Locate(k, after + 1);
+}
+
+template <typename Cost>
+void RouteSet<Cost>::Exchange(const int k1, const int i1, const int j1,
+                              const int k2, const int i2, const int j2) {
+  const auto &nodes_1 = routes_[k1].Nodes();
+  const auto &nodes_2 = routes_[k2].Nodes();
+  const std::vector<int> segment_1(std::next(nodes_1.begin(), i1 + 1),
+                                   std::next(nodes_1.begin(), j1 + 1));
+  const std::vector<int> segment_2(std::next(nodes_2.begin(), i2 + 1),
+                                   std::next(nodes_2.begin(), j2 + 1));
+  routes_[k1].Replace(i1, j1, segment_2);
+  routes_[k2].Replace(i2, j2, segment_1);
+  Locate(k1, i1 + 1);
+  Locate(k2, i2 + 1);
+}
+
+template <typename Cost>
+Cost RouteSet<Cost>::ExchangeDelta(const int k1, const int i1, const int j1,
+                                   const int k2, const int i2,
+                                   const int j2) const {
+  const auto &a = routes_[k1];
+  const auto &b = routes_[k2];
+  return Link(a, i1, j1, b, i2, j2) + Link(b, i2, j2, a, i1, j1) -
+         Link(a, i1, j1, a, i1, j1) - Link(b, i2, j2, b, i2, j2);
+}
+
+template <typename Cost>
+void RouteSet<Cost>::Reverse(const int k, const int i, const int j) {
+  routes_[k].Reverse(i, j);
+  Locate(k, i);
+}
+
+template <typename Cost>
+void RouteSet<Cost>::WriteBack(
+    std::vector<Vehicle> &vehicles,
+    const std::vector<std::vector<double>> &distanceMatrix,
+    const int capacity) const {
+  for (int k = 0; k < Size(); k++) {
+    vehicles[k].nodes_ = routes_[k].Nodes();
+    vehicles[k].load_ = capacity - routes_[k].Load();
+    vehicles[k].CalculateCost(distanceMatrix);
+  }
+}
+
+template <typename Cost>
+void RouteSet<Cost>::Locate(const int k, const int from) {
+  const auto &route = routes_[k];
+  // The depot is not located
+  for (int pos = std::max(from, 1); pos + 1 < route.Size(); pos++) {
+    route_of_[route[pos]] = k;
+    pos_of_[route[pos]] = pos;
+  }
+}
+
+template <typename Cost>
+Cost RouteSet<Cost>::Link(const Route<Cost> &a, const int i, const int j,
+                          const Route<Cost> &b, const int k,
+                          const int l) const {
+  if (k == l) {
+    return (*costs_)(a[i], a[j + 1]);
+  }
+  return (*costs_)(a[i], b[k + 1]) + (*costs_)(b[l], a[j + 1]);
+}
+
+template class Route<double>;
+template class Route<float>;
+template class Route<int32_t>;
+template class RouteSet<double>;
+template class RouteSet<float>;
+template class RouteSet<int32_t>;
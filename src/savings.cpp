@@ -0,0 +1,117 @@
+/**
+ * @file savings.cpp
+ * @author vss2sn
+ * @brief Contains the SavingsSolution class (Clarke-Wright savings algorithm)
+ */
+
+#include "cvrp/savings.hpp"
+
+#include <array>
+#include <iostream>
+#include <queue>
+#include <tuple>
+
+#include "cvrp/neighbor_lists.hpp"
+
+SavingsSolution::SavingsSolution(
+    const std::vector<Node>& nodes, const std::vector<Vehicle>& vehicles,
+    const std::vector<std::vector<double>>& distanceMatrix)
+    : Solution(nodes, vehicles, distanceMatrix) {}
+
+SavingsSolution::SavingsSolution(const Problem& p) : Solution(p) {}
+
+void SavingsSolution::Solve() {
+  const int depot = depot_.id_;
+  const size_t n = nodes_.size();
+
+  // Every route is kept as an undirected path: each node stores its two
+  // neighbors on the path (the depot if it is an end of the route), and each
+  // end of a route stores the other end and the load of the route.
+  std::vector<std::array<int, 2>> links(n, {depot, depot});
+  std::vector<int> other_end(n);
+  std::vector<int> load(n, 0);
+  for (size_t i = 0; i < n; i++) {
+    other_end[i] = i;
+    load[i] = nodes_[i].demand_;
+  }
+  const auto is_end = [&](const int i) {
+    return links[i][0] == depot || links[i][1] == depot;
+  };
+  const auto link = [&](const int i, const int j) {
+    auto& slot = (links[i][0] == depot) ? links[i][0] : links[i][1];
+    slot = j;
+  };
+
+  std::priority_queue<std::tuple<double, int, int>> savings;
+  for (size_t i = 0; i < n; i++) {
+    if (int(i) == depot || nodes_[i].is_routed_) {
+      continue;
+    }
+    for (const int j : neighbors_->Of(i)) {
+      if (int(i) < j && !nodes_[j].is_routed_) {
+        const double saving = (*distanceMatrix_)[depot][i] +
+                              (*distanceMatrix_)[depot][j] -
+                              (*distanceMatrix_)[i][j];
+        if (saving > 0) {
+          savings.emplace(saving, i, j);
+        }
+      }
+    }
+  }
+
+  while (!savings.empty()) {
+    const auto [saving, i, j] = savings.top();
+    savings.pop();
+    // Entries are invalidated lazily: the nodes must still be the ends of two
+    // different routes that fit in a vehicle together
+    if (!is_end(i) || !is_end(j) || other_end[i] == j ||
+        load[i] + load[j] > capacity_) {
+      continue;
+    }
+    const int end_i = other_end[i];
+    const int end_j = other_end[j];
+    link(i, j);
+    link(j, i);
+    other_end[end_i] = end_j;
+    other_end[end_j] = end_i;
+    load[end_i] = load[end_j] = load[i] + load[j];
+  }
+
+  // Walk every route from one of its ends and hand it to the next vehicle
+  std::vector<bool> visited(n, false);
+  visited[depot] = true;
+  auto v = vehicles_.begin();
+  for (size_t i = 0; i < n && v != vehicles_.end(); i++) {
+    if (visited[i] || nodes_[i].is_routed_ || !is_end(i)) {
+      continue;
+    }
+    int prev = depot;
+    int cur = i;
+    while (cur != depot) {
+      visited[cur] = true;
+      v->nodes_.push_back(cur);
+      v->load_ -= nodes_[cur].demand_;
+      nodes_[cur].is_routed_ = true;
+      const int next = (links[cur][0] == prev) ? links[cur][1] : links[cur][0];
+      prev = cur;
+      cur = next;
+    }
+    v->nodes_.push_back(depot);
+    v->CalculateCost(*distanceMatrix_);
+    ++v;
+  }
+  for (; v != vehicles_.end(); ++v) {
+    v->nodes_.push_back(depot);
+    v->CalculateCost(*distanceMatrix_);
+  }
+
+  if (!verbose_) {
+    return;
+  }
+  for (const auto& i : nodes_) {
+    if (!i.is_routed_) {
+      std::cout << "\t Unreached node: ";
+      std::cout << OriginalNode(i) << '\n';
+    }
+  }
+}
@@ -0,0 +1,319 @@
+/**
+ * @file simulated_annealing.cpp
+ * @author vss2sn
+ * @brief Contains the SimulatedAnnealingSolution class
+ */
+
+#include "cvrp/simulated_annealing.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <numeric>
+#include <random>
+
+#include "cvrp/neighbor_lists.hpp"
+#include "cvrp/route.hpp"
+
+namespace {
+
+constexpr long long check_interval = 1024;  // moves between budget checks
+constexpr int n_samples = 1000;  // moves sampled for the initial temperature
+constexpr double initial_acceptance = 0.5;  // of the average uphill move
+constexpr double final_temperature_ratio = 0.001;
+
+enum class MoveType { RELOCATE, SWAP, TWO_OPT };
+
+/**
+ * @brief struct Proposal
+ * @details Move proposed by the simulated annealing. A relocation moves node_
+ * to the position after i2_ in route r2_. A reversal (2-opt within a route)
+ * reverses the positions i1_ to j1_ of route r1_. Any other move exchanges the
+ * segment (i1_, j1_] of route r1_ with the segment (i2_, j2_] of route r2_.
+ */
+template <typename Cost>
+struct Proposal {
+ public:
+  MoveType type_ = MoveType::RELOCATE;
+  int node_ = -1;
+  int r1_ = -1;
+  int i1_ = -1;
+  int j1_ = -1;
+  int r2_ = -1;
+  int i2_ = -1;
+  int j2_ = -1;
+  Cost delta_ = 0;
+};
+
+}  // namespace
+
+SimulatedAnnealingSolution::SimulatedAnnealingSolution(
+    const std::vector<Node>& nodes, const std::vector<Vehicle>& vehicles,
+    const std::vector<std::vector<double>>& distanceMatrix,
+    const AnnealingParameters& params)
+    : Solution(nodes, vehicles, distanceMatrix), params_(params) {
+  CreateInitialSolution();
+}
+
+SimulatedAnnealingSolution::SimulatedAnnealingSolution(
+    const Problem& p, const AnnealingParameters& params)
+    : Solution(p), params_(params) {
+  CreateInitialSolution();
+}
+
+SimulatedAnnealingSolution::SimulatedAnnealingSolution(
+    const Solution& s, const AnnealingParameters& params)
+    : Solution(s), params_(params) {
+  if (!s.CheckSolutionValid()) {
+    std::cout << "The input solution is invalid. Exiting." << '\n';
+    exit(0);
+  }
+}
+
+void SimulatedAnnealingSolution::Solve() {
+  switch (cost_type_) {
+    case CostType::FLOAT:
+      Anneal<float>();
+      break;
+    case CostType::ROUNDED:
+      Anneal<int32_t>();
+      break;
+    default:
+      Anneal<double>();
+      break;
+  }
+  if (!verbose_) {
+    return;
+  }
+  for (const auto& i : nodes_) {
+    if (!i.is_routed_) {
+      std::cout << "Unreached node: " << '\n';
+      std::cout << OriginalNode(i) << '\n';
+    }
+  }
+  std::cout << "\n";
+  PrintSolution("route");
+}
+
+bool SimulatedAnnealingSolution::Step(const double seconds) {
+  const double cost = TotalCost();
+  const auto params = params_;
+  const bool verbose = verbose_;
+  params_.move_budget_ = 0;
+  params_.time_budget_ = seconds;
+  verbose_ = false;
+  Solve();
+  params_ = params;
+  verbose_ = verbose;
+  if (TotalCost() < cost) {
+    ReportIncumbent();
+  }
+  return true;
+}
+
+template <typename Cost>
+void SimulatedAnnealingSolution::Anneal() {
+  const CostMatrix<Cost> costs(*distanceMatrix_);
+  const auto& neighbors = *neighbors_;
+  RouteSet<Cost> routes(vehicles_, nodes_, costs);
+
+  std::vector<int> customers;
+  for (size_t u = 0; u < nodes_.size(); u++) {
+    if (routes.RouteOf(u) >= 0) {
+      customers.push_back(u);
+    }
+  }
+  if (customers.empty() || neighbors.K() == 0) {
+    return;
+  }
+
+  std::default_random_engine rng(rand());
+  std::uniform_int_distribution<size_t> pick_node(0, customers.size() - 1);
+  std::uniform_int_distribution<size_t> pick_neighbor(0, neighbors.K() - 1);
+  std::uniform_int_distribution<int> pick_type(0, 2);
+  std::uniform_int_distribution<int> pick_side(0, 1);
+  std::uniform_real_distribution<double> unit(0, 1);
+
+  // Exchange of the segments of two different routes; false if either route
+  // would exceed the capacity
+  const auto exchange = [&](Proposal<Cost>& m) {
+    const auto& a = routes[m.r1_];
+    const auto& b = routes[m.r2_];
+    if (m.i1_ < 0 || m.i2_ < 0 || m.j1_ > a.Size() - 2 ||
+        m.j2_ > b.Size() - 2 || (m.i1_ == m.j1_ && m.i2_ == m.j2_)) {
+      return false;
+    }
+    const int load_1 = a.Load(m.i1_, m.j1_);
+    const int load_2 = b.Load(m.i2_, m.j2_);
+    if (a.Load() - load_1 + load_2 > capacity_ ||
+        b.Load() - load_2 + load_1 > capacity_) {
+      return false;
+    }
+    m.delta_ = routes.ExchangeDelta(m.r1_, m.i1_, m.j1_, m.r2_, m.i2_, m.j2_);
+    return true;
+  };
+
+  // Proposes a move that places a random node next to one of its neighbors;
+  // false if the move is not possible
+  const auto propose = [&](Proposal<Cost>& m) {
+    const int u = customers[pick_node(rng)];
+    const int w = neighbors.Of(u).begin()[pick_neighbor(rng)];
+    m.r2_ = routes.RouteOf(w);
+    if (m.r2_ < 0) {
+      return false;
+    }
+    m.type_ = static_cast<MoveType>(pick_type(rng));
+    m.node_ = u;
+    m.r1_ = routes.RouteOf(u);
+    const auto& a = routes[m.r1_];
+    const auto& b = routes[m.r2_];
+    const int p = routes.PositionOf(u);
+    const int q = routes.PositionOf(w);
+    const bool after = pick_side(rng) == 0;
+    switch (m.type_) {
+      case MoveType::RELOCATE: {
+        if ((m.r1_ == m.r2_ && q == p - 1) ||
+            (m.r1_ != m.r2_ &&
+             b.Load() + nodes_[u].demand_ > capacity_)) {
+          return false;
+        }
+        m.i2_ = q;
+        m.delta_ = costs(a[p - 1], a[p + 1]) - costs(a[p - 1], u) -
+                   costs(u, a[p + 1]) + costs(w, u) + costs(u, b[q + 1]) -
+                   costs(w, b[q + 1]);
+        return true;
+      }
+      case MoveType::SWAP: {
+        // Swap with the node after or before the neighbor
+        if (m.r1_ == m.r2_) {
+          return false;
+        }
+        const int x = after ? q + 1 : q - 1;
+        m.i1_ = p - 1;
+        m.j1_ = p;
+        m.i2_ = x - 1;
+        m.j2_ = x;
+        return x >= 1 && exchange(m);
+      }
+      default: {
+        if (m.r1_ != m.r2_) {
+          // Exchange of the tails of the routes
+          m.i1_ = after ? p - 1 : p;
+          m.j1_ = a.Size() - 2;
+          m.i2_ = after ? q : q - 1;
+          m.j2_ = b.Size() - 2;
+          return exchange(m);
+        }
+        // Reversal of the segment between the node and the neighbor
+        m.i1_ = std::min(p, q) + 1;
+        m.j1_ = std::max(p, q);
+        if (m.i1_ >= m.j1_) {
+          return false;
+        }
+        m.delta_ = costs(a[m.i1_ - 1], a[m.j1_]) +
+                   costs(a[m.i1_], a[m.j1_ + 1]) -
+                   costs(a[m.i1_ - 1], a[m.i1_]) -
+                   costs(a[m.j1_], a[m.j1_ + 1]);
+        return true;
+      }
+    }
+  };
+
+  const auto apply = [&](const Proposal<Cost>& m) {
+    if (m.type_ == MoveType::RELOCATE) {
+      routes.Relocate(m.node_, m.r2_, m.i2_);
+    } else if (m.r1_ == m.r2_) {
+      routes.Reverse(m.r1_, m.i1_, m.j1_);
+    } else {
+      routes.Exchange(m.r1_, m.i1_, m.j1_, m.r2_, m.i2_, m.j2_);
+    }
+  };
+
+  // The initial temperature accepts the average uphill move with probability
+  // initial_acceptance
+  Proposal<Cost> m;
+  double initial_temperature = params_.initial_temperature_;
+  if (initial_temperature <= 0) {
+    double uphill = 0;
+    int n_uphill = 0;
+    for (int i = 0; i < n_samples; i++) {
+      if (propose(m) && m.delta_ > 0) {
+        uphill += static_cast<double>(m.delta_);
+        n_uphill++;
+      }
+    }
+    initial_temperature =
+        n_uphill > 0 ? uphill / n_uphill / -std::log(initial_acceptance) : 1;
+  }
+  const double final_temperature =
+      params_.final_temperature_ > 0
+          ? params_.final_temperature_
+          : initial_temperature * final_temperature_ratio;
+  const auto temperature_at = [&](const double progress) {
+    if (params_.schedule_ == CoolingSchedule::LINEAR) {
+      return initial_temperature +
+             (final_temperature - initial_temperature) * progress;
+    }
+    return initial_temperature *
+           std::pow(final_temperature / initial_temperature, progress);
+  };
+
+  long long move_budget = params_.move_budget_;
+  if (move_budget <= 0 && params_.time_budget_ <= 0) {
+    move_budget = AnnealingParameters().move_budget_;
+  }
+
+  // The best routes are only copied when the search is about to move away
+  // from them
+  Cost current = 0;
+  for (int k = 0; k < routes.Size(); k++) {
+    current += routes[k].Distance();
+  }
+  Cost best = current;
+  RouteSet<Cost> best_routes = routes;
+  bool best_saved = true;
+
+  const auto start = std::chrono::steady_clock::now();
+  double temperature = initial_temperature;
+  for (long long move = 0;; move++) {
+    if (move % check_interval == 0) {
+      double progress = 0;
+      if (move_budget > 0) {
+        progress = static_cast<double>(move) / move_budget;
+      }
+      if (params_.time_budget_ > 0) {
+        const std::chrono::duration<double> elapsed =
+            std::chrono::steady_clock::now() - start;
+        progress = std::max(progress, elapsed.count() / params_.time_budget_);
+      }
+      if (progress >= 1) {
+        break;
+      }
+      temperature = temperature_at(progress);
+    }
+    if (!propose(m)) {
+      continue;
+    }
+    if (m.delta_ > 0) {
+      if (unit(rng) >= std::exp(-static_cast<double>(m.delta_) / temperature)) {
+        continue;
+      }
+      if (!best_saved) {
+        best_routes = routes;
+        best_saved = true;
+      }
+    }
+    apply(m);
+    current += m.delta_;
+    if (current < best) {
+      best = current;
+      best_saved = false;
+    }
+  }
+  if (best_saved) {
+    routes = best_routes;
+  }
+  routes.WriteBack(vehicles_, *distanceMatrix_, capacity_);
+}
@@ -0,0 +1,508 @@
+/**
+ * @file solution_cache.cpp
+ * @author vss2sn
+ * @brief Contains the SolutionCache class, an on-disk store of the best known
+ * solution of each instance
+ */
+
+#include "cvrp/solution_cache.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <tuple>
+#include <utility>
+
+#include "cvrp/kd_tree.hpp"
+
+namespace {
+
+constexpr uint64_t fnv_offset_basis = 14695981039346656037ULL;
+constexpr uint64_t fnv_prime = 1099511628211ULL;
+constexpr char cache_format[] = "cvrp-solution-cache";
+constexpr int cache_version = 2;
+constexpr char cache_extension[] = ".sol";
+constexpr size_t max_features = 64;
+// Bounds the counts read from a file, so a corrupted count fails the read
+// instead of exhausting memory
+constexpr size_t max_nodes = 1 << 24;
+
+/**
+ * @brief Adds the bytes of a value to a FNV-1a hash
+ * @param hash hash to be updated
+ * @param value value whose bytes are hashed
+ * @return void
+ */
+template <typename T>
+void Hash(uint64_t& hash, const T& value) {
+  unsigned char bytes[sizeof(T)];
+  std::memcpy(bytes, &value, sizeof(T));
+  for (const auto byte : bytes) {
+    hash ^= byte;
+    hash *= fnv_prime;
+  }
+}
+
+/**
+ * @brief struct CacheHeader
+ * @details Lines of a cache file that precede the routes
+ */
+struct CacheHeader {
+ public:
+  uint64_t hash_ = 0;
+  std::vector<double> features_;
+  double cost_ = 0;
+  size_t n_routes_ = 0;
+};
+
+/**
+ * @brief Reads the lines of a cache file that precede the routes
+ * @param is stream read from
+ * @param header header read
+ * @return bool True if the header was read and has the current format
+ */
+bool ReadHeader(std::istream& is, CacheHeader& header) {
+  std::string format;
+  int version = 0;
+  std::string label;
+  size_t n_features = 0;
+  if (!(is >> format >> version) || format != cache_format ||
+      version != cache_version || !(is >> label >> std::hex >> header.hash_) ||
+      label != "hash" || !(is >> std::dec >> label >> n_features) ||
+      label != "features" || n_features > max_features) {
+    return false;
+  }
+  header.features_.resize(n_features);
+  for (auto& f : header.features_) {
+    if (!(is >> f)) {
+      return false;
+    }
+  }
+  return (is >> label >> header.cost_) && label == "cost" &&
+         (is >> label >> header.n_routes_) && label == "routes" &&
+         header.n_routes_ <= max_nodes;
+}
+
+/**
+ * @brief Reads the routes of a cache file
+ * @param is stream read from, positioned after the header
+ * @param n_routes number of routes
+ * @param routes routes read
+ * @return bool True if the routes were read
+ */
+bool ReadRoutes(std::istream& is, const size_t n_routes, Routes& routes) {
+  // Grown as the file is read rather than sized from the counts in it
+  routes.clear();
+  for (size_t k = 0; k < n_routes; ++k) {
+    size_t length = 0;
+    if (!(is >> length) || length > max_nodes) {
+      return false;
+    }
+    auto& route = routes.emplace_back();
+    for (size_t i = 0; i < length; ++i) {
+      int id = 0;
+      if (!(is >> id)) {
+        return false;
+      }
+      route.push_back(id);
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief Checks the ids of the routes
+ * @param routes routes to be checked
+ * @param n_nodes number of nodes of the instance
+ * @return bool True if every id is a customer of the instance and is visited
+ * at most once
+ */
+bool ValidIds(const Routes& routes, const size_t n_nodes) {
+  std::vector<char> visited(n_nodes, 0);
+  for (const auto& route : routes) {
+    for (const int id : route) {
+      if (id <= 0 || id >= static_cast<int>(n_nodes) || visited[id]) {
+        return false;
+      }
+      visited[id] = 1;
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief Reads the coordinates of the nodes of a cache file
+ * @param is stream read from, positioned after the routes
+ * @param nodes nodes read, depot first; ids are their indices
+ * @return bool True if the nodes were read, the depot at least
+ */
+bool ReadNodes(std::istream& is, std::vector<Node>& nodes) {
+  std::string label;
+  size_t n_nodes = 0;
+  if (!(is >> label >> n_nodes) || label != "nodes" || n_nodes == 0 ||
+      n_nodes > max_nodes) {
+    return false;
+  }
+  nodes.clear();
+  for (size_t i = 0; i < n_nodes; ++i) {
+    float x = 0;
+    float y = 0;
+    if (!(is >> x >> y)) {
+      return false;
+    }
+    nodes.emplace_back(x, y, i);
+  }
+  return true;
+}
+
+/**
+ * @brief Euclidean distance between the locations of two nodes
+ * @param a node
+ * @param b node
+ * @return double distance
+ */
+double Distance(const Node& a, const Node& b) {
+  return std::hypot(static_cast<double>(a.x_ - b.x_),
+                    static_cast<double>(a.y_ - b.y_));
+}
+
+/**
+ * @brief Difference between the features of two instances
+ * @param a features of an instance
+ * @param b features of another instance
+ * @return double sum of the differences of the features relative to the larger
+ * of the two values
+ */
+double FeatureDistance(const std::vector<double>& a,
+                       const std::vector<double>& b) {
+  double distance = 0;
+  for (size_t i = 0; i < a.size(); ++i) {
+    const double scale = std::max(std::abs(a[i]), std::abs(b[i]));
+    if (scale > 0) {
+      distance += std::abs(a[i] - b[i]) / scale;
+    }
+  }
+  return distance;
+}
+
+/**
+ * @brief Coordinates relative to the depot, scaled by the mean distance of the
+ * customers to the depot
+ * @param nodes nodes of an instance, depot first
+ * @return std::vector<Node> nodes with the scaled coordinates
+ */
+std::vector<Node> Normalise(std::vector<Node> nodes) {
+  const Node depot = nodes[0];
+  double total = 0;
+  for (size_t i = 1; i < nodes.size(); ++i) {
+    total += Distance(nodes[i], depot);
+  }
+  const double mean = nodes.size() > 1 ? total / (nodes.size() - 1) : 0;
+  const double scale = mean > 0 ? 1 / mean : 1;
+  for (auto& n : nodes) {
+    n.x_ = static_cast<float>(static_cast<double>(n.x_ - depot.x_) * scale);
+    n.y_ = static_cast<float>(static_cast<double>(n.y_ - depot.y_) * scale);
+  }
+  return nodes;
+}
+
+/**
+ * @brief Splits customers, in the order they are visited, into routes
+ * @param p Instance of Problem class defining the problem parameters
+ * @param order customers in the order they are visited
+ * @param group route of each customer in the solution the order was taken
+ * from; a new route is started where it changes or the capacity would be
+ * exceeded
+ * @return Routes routes, empty if they need more vehicles than the fleet has
+ */
+Routes Split(const Problem& p, const std::vector<int>& order,
+             const std::vector<int>& group) {
+  Routes routes;
+  int load = 0;
+  for (size_t i = 0; i < order.size(); ++i) {
+    const int demand = p.nodes_[order[i]].demand_;
+    if (routes.empty() || group[i] != group[i - 1] ||
+        load + demand > p.capacity_) {
+      if (routes.size() == p.vehicles_.size()) {
+        return {};
+      }
+      routes.emplace_back();
+      load = 0;
+    }
+    routes.back().push_back(order[i]);
+    load += demand;
+  }
+  return routes;
+}
+
+/**
+ * @brief Maps a solution of another instance onto a problem
+ * @param p Instance of Problem class defining the problem parameters
+ * @param nodes nodes of the other instance, depot first
+ * @param routes routes of the solution of the other instance
+ * @return Routes routes visiting the customers of p, empty if they need more
+ * vehicles than the fleet has
+ */
+Routes TransferRoutes(const Problem& p, const std::vector<Node>& nodes,
+                      const Routes& routes) {
+  std::vector<int> route_of(nodes.size(), 0);
+  std::vector<int> position(nodes.size(), 0);
+  std::vector<int> ids;
+  for (size_t k = 0; k < routes.size(); ++k) {
+    for (const int id : routes[k]) {
+      route_of[id] = k;
+      position[id] = ids.size();
+      ids.push_back(id);
+    }
+  }
+  // Checked before normalising, which needs at least the depot
+  if (ids.empty()) {
+    return {};
+  }
+  const auto source = Normalise(nodes);
+  const auto target = Normalise(p.nodes_);
+
+  // Customers are visited in the order of their matches; customers matched to
+  // the same one are visited nearest first
+  const KdTree tree(source, ids);
+  std::vector<std::tuple<int, double, int>> matches;
+  matches.reserve(target.size() - 1);
+  for (size_t i = 1; i < target.size(); ++i) {
+    const auto& n = target[i];
+    const int match = tree.Nearest(n.x_, n.y_, 1).front();
+    matches.emplace_back(position[match], Distance(n, source[match]), i);
+  }
+  std::sort(matches.begin(), matches.end());
+  std::vector<int> order;
+  std::vector<int> group;
+  for (const auto& [pos, d, id] : matches) {
+    order.push_back(id);
+    group.push_back(route_of[ids[pos]]);
+  }
+
+  // The routes of the matches are kept if the fleet allows it
+  auto transferred = Split(p, order, group);
+  if (transferred.empty()) {
+    transferred = Split(p, order, std::vector<int>(order.size(), 0));
+  }
+  return transferred;
+}
+
+}  // namespace
+
+uint64_t InstanceHash(const Problem& p) {
+  uint64_t hash = fnv_offset_basis;
+  Hash(hash, p.nodes_.size());
+  for (const auto& n : p.nodes_) {
+    Hash(hash, n.x_);
+    Hash(hash, n.y_);
+    Hash(hash, n.demand_);
+  }
+  Hash(hash, p.capacity_);
+  Hash(hash, p.vehicles_.size());
+  Hash(hash, static_cast<int>(p.cost_type_));
+  return hash;
+}
+
+std::vector<double> InstanceFeatures(const Problem& p) {
+  const auto& depot = p.nodes_[0];
+  const size_t n_customers = p.nodes_.size() - 1;
+  const double n = std::max<size_t>(n_customers, 1);
+  std::vector<int> ids;
+  for (size_t i = 1; i < p.nodes_.size(); ++i) {
+    ids.push_back(i);
+  }
+  const KdTree tree(p.nodes_, ids);
+  double total_demand = 0;
+  double sum_d = 0;
+  double sum_d2 = 0;
+  double cx = 0;
+  double cy = 0;
+  double sum_nearest = 0;
+  for (const int i : ids) {
+    const auto& c = p.nodes_[i];
+    const double d = Distance(c, depot);
+    total_demand += c.demand_;
+    sum_d += d;
+    sum_d2 += d * d;
+    cx += static_cast<double>(c.x_);
+    cy += static_cast<double>(c.y_);
+    const auto nearest = tree.Nearest(c.x_, c.y_, 1, i);
+    if (!nearest.empty()) {
+      sum_nearest += Distance(c, p.nodes_[nearest.front()]);
+    }
+  }
+  const double capacity = std::max(p.capacity_, 1);
+  const double fleet = std::max<size_t>(p.vehicles_.size(), 1);
+  const double mean_d = sum_d / n;
+  return {static_cast<double>(n_customers),
+          static_cast<double>(p.capacity_),
+          static_cast<double>(p.vehicles_.size()),
+          total_demand / n / capacity,
+          std::ceil(total_demand / capacity),
+          total_demand / (fleet * capacity),
+          mean_d,
+          std::sqrt(std::max(0.0, sum_d2 / n - mean_d * mean_d)),
+          sum_nearest / n,
+          std::hypot(cx / n - static_cast<double>(depot.x_),
+                     cy / n - static_cast<double>(depot.y_))};
+}
+
+CachedSolution::CachedSolution(const Problem& p, const Routes& routes)
+    : Solution(p) {
+  for (size_t k = 0; k < routes.size() && k < vehicles_.size(); ++k) {
+    auto& v = vehicles_[k];
+    for (const int id : routes[k]) {
+      v.nodes_.push_back(id);
+      v.load_ -= nodes_[id].demand_;
+      nodes_[id].is_routed_ = true;
+    }
+  }
+  for (auto& v : vehicles_) {
+    v.nodes_.push_back(depot_.id_);
+    v.CalculateCost(*distanceMatrix_);
+  }
+}
+
+SolutionCache::SolutionCache(std::string directory)
+    : directory_(std::move(directory)) {}
+
+std::string SolutionCache::Path(const Problem& p) const {
+  std::ostringstream name;
+  name << std::hex << std::setw(16) << std::setfill('0') << InstanceHash(p)
+       << cache_extension;
+  return (std::filesystem::path(directory_) / name.str()).string();
+}
+
+std::unique_ptr<CachedSolution> SolutionCache::Lookup(
+    const Problem& p) const {
+  std::ifstream is(Path(p));
+  CacheHeader header;
+  Routes routes;
+  if (!ReadHeader(is, header) || header.hash_ != InstanceHash(p) ||
+      header.n_routes_ > p.vehicles_.size() ||
+      !ReadRoutes(is, header.n_routes_, routes) ||
+      !ValidIds(routes, p.nodes_.size())) {
+    return nullptr;
+  }
+  auto solution = std::make_unique<CachedSolution>(p, routes);
+  if (!solution->CheckSolutionValid()) {
+    return nullptr;
+  }
+  return solution;
+}
+
+bool SolutionCache::Store(const Problem& p, const Solution& s) const {
+  if (!s.CheckSolutionValid()) {
+    return false;
+  }
+  const auto stored = Lookup(p);
+  if (stored && stored->TotalCost() <= s.TotalCost()) {
+    return false;
+  }
+
+  std::error_code error;
+  std::filesystem::create_directories(directory_, error);
+  const std::string path = Path(p);
+  // Writers of the same instance (eg concurrent batch jobs) use their own
+  // temporary files, so only the renames race
+  std::ostringstream suffix;
+  suffix << std::hex << std::random_device()() << std::random_device()();
+  const std::string temp = path + "." + suffix.str() + ".tmp";
+  {
+    std::ofstream os(temp, std::ios::trunc);
+    os << cache_format << ' ' << cache_version << '\n';
+    os << "hash " << std::hex << InstanceHash(p) << std::dec << '\n';
+    os << std::setprecision(std::numeric_limits<double>::max_digits10);
+    const auto features = InstanceFeatures(p);
+    os << "features " << features.size();
+    for (const double f : features) {
+      os << ' ' << f;
+    }
+    os << '\n';
+    os << "cost " << s.TotalCost() << '\n';
+    const auto vehicles = s.GetVehicles();
+    os << "routes " << vehicles.size() << '\n';
+    for (const auto& v : vehicles) {
+      // Routes start and end at the depot, which is not stored
+      const size_t length = v.nodes_.size() > 2 ? v.nodes_.size() - 2 : 0;
+      os << length;
+      for (size_t i = 1; i <= length; ++i) {
+        os << ' ' << v.nodes_[i];
+      }
+      os << '\n';
+    }
+    // Used to map the solution onto similar instances
+    os << "nodes " << p.nodes_.size() << '\n';
+    for (const auto& n : p.nodes_) {
+      os << n.x_ << ' ' << n.y_ << '\n';
+    }
+    os.flush();
+    if (!os) {
+      std::remove(temp.c_str());
+      return false;
+    }
+  }
+  // Narrows the window in which a better solution stored by another writer
+  // could be replaced
+  const auto latest = Lookup(p);
+  if (latest && latest->TotalCost() <= s.TotalCost()) {
+    std::remove(temp.c_str());
+    return false;
+  }
+  std::filesystem::rename(temp, path, error);
+  if (error) {
+    std::remove(temp.c_str());
+    return false;
+  }
+  return true;
+}
+
+std::vector<Routes> SolutionCache::Transfer(const Problem& p,
+                                            const size_t n_neighbors) const {
+  const uint64_t hash = InstanceHash(p);
+  const auto features = InstanceFeatures(p);
+  std::vector<std::pair<double, std::string>> candidates;
+  std::error_code error;
+  for (const auto& entry :
+       std::filesystem::directory_iterator(directory_, error)) {
+    if (entry.path().extension() != cache_extension) {
+      continue;
+    }
+    std::ifstream is(entry.path());
+    CacheHeader header;
+    if (ReadHeader(is, header) && header.hash_ != hash &&
+        header.features_.size() == features.size()) {
+      candidates.emplace_back(FeatureDistance(features, header.features_),
+                              entry.path().string());
+    }
+  }
+  std::sort(candidates.begin(), candidates.end());
+
+  std::vector<Routes> solutions;
+  for (const auto& candidate : candidates) {
+    if (solutions.size() == n_neighbors) {
+      break;
+    }
+    std::ifstream is(candidate.second);
+    CacheHeader header;
+    Routes routes;
+    std::vector<Node> nodes;
+    if (!ReadHeader(is, header) || !ReadRoutes(is, header.n_routes_, routes) ||
+        !ReadNodes(is, nodes) || !ValidIds(routes, nodes.size())) {
+      continue;
+    }
+    auto transferred = TransferRoutes(p, nodes, routes);
+    if (!transferred.empty()) {
+      solutions.push_back(std::move(transferred));
+    }
+  }
+  return solutions;
+}
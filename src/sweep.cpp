@@ -0,0 +1,77 @@
+/**
+ * @file sweep.cpp
+ * @author vss2sn
+ * @brief Contains the SweepSolution class (sweep algorithm)
+ */
+
+#include "cvrp/sweep.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <utility>
+
+#include "cvrp/education.hpp"
+
+constexpr double two_pi = 6.28318530717958647692;
+
+SweepSolution::SweepSolution(
+    const std::vector<Node>& nodes, const std::vector<Vehicle>& vehicles,
+    const std::vector<std::vector<double>>& distanceMatrix)
+    : Solution(nodes, vehicles, distanceMatrix) {}
+
+SweepSolution::SweepSolution(const Problem& p) : Solution(p) {}
+
+void SweepSolution::Solve() {
+  std::vector<std::pair<double, int>> angles;
+  for (const auto& n : nodes_) {
+    if (!n.is_routed_) {
+      angles.emplace_back(
+          std::atan2(n.y_ - depot_.y_, n.x_ - depot_.x_), n.id_);
+    }
+  }
+  std::sort(angles.begin(), angles.end());
+
+  // Start the sweep after the largest gap so that no route spans it
+  size_t start = 0;
+  double largest_gap = -1;
+  for (size_t i = 0; i < angles.size(); i++) {
+    const double prev = (i == 0) ? angles.back().first - two_pi
+                                 : angles[i - 1].first;
+    if (angles[i].first - prev > largest_gap) {
+      largest_gap = angles[i].first - prev;
+      start = i;
+    }
+  }
+  std::rotate(angles.begin(), angles.begin() + start, angles.end());
+
+  EducationParameters params;
+  params.move_budget_ = 0;
+  auto v = vehicles_.begin();
+  auto it = angles.begin();
+  while (v != vehicles_.end()) {
+    while (it != angles.end() && v->load_ - nodes_[it->second].demand_ >= 0) {
+      v->load_ -= nodes_[it->second].demand_;
+      v->nodes_.push_back(it->second);
+      nodes_[it->second].is_routed_ = true;
+      ++it;
+    }
+    v->nodes_.push_back(depot_.id_);
+    v->CalculateCost(*distanceMatrix_);
+    // A single route, so only the moves within the route apply
+    std::vector<Vehicle> route{*v};
+    EducateRoutes(route, nodes_, *distanceMatrix_, *neighbors_, params);
+    *v = std::move(route.front());
+    ++v;
+  }
+
+  if (!verbose_) {
+    return;
+  }
+  for (const auto& i : nodes_) {
+    if (!i.is_routed_) {
+      std::cout << "\t Unreached node: ";
+      std::cout << OriginalNode(i) << '\n';
+    }
+  }
+}
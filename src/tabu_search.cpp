@@ -0,0 +1,422 @@
+/**
+ * @file tabu_search.cpp
+ * @author vss2sn
+ * @brief Contains the TabuSearchSolution class
+ */
+
+#include "cvrp/tabu_search.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <random>
+
+#include "cvrp/neighbor_lists.hpp"
+#include "cvrp/route.hpp"
+
+namespace {
+
+constexpr long long check_interval = 64;  // iterations between budget checks
+
+enum class MoveType { RELOCATE, SWAP, TWO_OPT };
+
+/**
+ * @brief struct TabuMove
+ * @details A relocation moves node_ to the position after i2_ in route r2_. A
+ * 2-opt move within a route reverses the positions i1_ to j1_ of route r1_.
+ * Any other move exchanges the segment (i1_, j1_] of route r1_ with the
+ * segment (i2_, j2_] of route r2_.
+ */
+template <typename Cost>
+struct TabuMove {
+ public:
+  MoveType type_ = MoveType::RELOCATE;
+  int node_ = -1;
+  int r1_ = -1;
+  int i1_ = -1;
+  int j1_ = -1;
+  int r2_ = -1;
+  int i2_ = -1;
+  int j2_ = -1;
+  Cost delta_ = std::numeric_limits<Cost>::max();
+};
+
+/**
+ * @brief class TabuMemory
+ * @details Open addressing hash table (linear probing) from an attribute to
+ * the last iteration at which it is tabu. Slots of expired attributes are
+ * reused, and the table is rebuilt with only the live attributes once half
+ * of its slots have been used, so its size only depends on the number of
+ * attributes that can be live at the same time.
+ */
+class TabuMemory {
+ public:
+  /**
+   * @brief Constructor
+   * @param max_live largest number of attributes live at the same time
+   * @return no return value
+   */
+  explicit TabuMemory(const size_t max_live) {
+    size_t capacity = 16;
+    while (capacity < 4 * max_live) {
+      capacity *= 2;
+    }
+    slots_.resize(capacity);
+  }
+
+  /**
+   * @brief Whether an attribute is tabu
+   * @param key attribute
+   * @param iteration current iteration
+   * @return bool True if the attribute is tabu at the iteration
+   */
+  bool IsTabu(const long long key, const long long iteration) const {
+    for (size_t i = Index(key);; i = (i + 1) & (slots_.size() - 1)) {
+      if (slots_[i].key_ == key) {
+        return slots_[i].until_ >= iteration;
+      }
+      if (slots_[i].key_ < 0) {
+        return false;
+      }
+    }
+  }
+
+  /**
+   * @brief Makes an attribute tabu
+   * @param key attribute
+   * @param iteration current iteration
+   * @param until last iteration at which the attribute is tabu
+   * @return void
+   */
+  void Add(const long long key, const long long iteration,
+           const long long until) {
+    size_t reusable = slots_.size();
+    size_t i = Index(key);
+    for (;; i = (i + 1) & (slots_.size() - 1)) {
+      if (slots_[i].key_ == key) {
+        slots_[i].until_ = until;
+        return;
+      }
+      if (slots_[i].key_ < 0) {
+        break;
+      }
+      if (reusable == slots_.size() && slots_[i].until_ < iteration) {
+        reusable = i;
+      }
+    }
+    if (reusable != slots_.size()) {
+      slots_[reusable] = {key, until};
+      return;
+    }
+    slots_[i] = {key, until};
+    if (++used_ * 2 > slots_.size()) {
+      Rebuild(iteration);
+    }
+  }
+
+ private:
+  struct Slot {
+   public:
+    long long key_ = -1;  // -1 if the slot has never been used
+    long long until_ = -1;
+  };
+  std::vector<Slot> slots_;
+  size_t used_ = 0;  // slots that have held an attribute since the rebuild
+
+  size_t Index(const long long key) const {
+    return (static_cast<uint64_t>(key) * 0x9E3779B97F4A7C15ULL >> 32) &
+           (slots_.size() - 1);
+  }
+
+  void Rebuild(const long long iteration) {
+    std::vector<Slot> live;
+    for (const auto& slot : slots_) {
+      if (slot.key_ >= 0 && slot.until_ >= iteration) {
+        live.push_back(slot);
+      }
+    }
+    std::fill(std::begin(slots_), std::end(slots_), Slot());
+    used_ = 0;
+    for (const auto& slot : live) {
+      size_t i = Index(slot.key_);
+      while (slots_[i].key_ >= 0) {
+        i = (i + 1) & (slots_.size() - 1);
+      }
+      slots_[i] = slot;
+      used_++;
+    }
+  }
+};
+
+}  // namespace
+
+TabuSearchSolution::TabuSearchSolution(
+    const std::vector<Node>& nodes, const std::vector<Vehicle>& vehicles,
+    const std::vector<std::vector<double>>& distanceMatrix,
+    const TabuParameters& params)
+    : Solution(nodes, vehicles, distanceMatrix), params_(params) {
+  CreateInitialSolution();
+}
+
+TabuSearchSolution::TabuSearchSolution(const Problem& p,
+                                       const TabuParameters& params)
+    : Solution(p), params_(params) {
+  CreateInitialSolution();
+}
+
+TabuSearchSolution::TabuSearchSolution(const Solution& s,
+                                       const TabuParameters& params)
+    : Solution(s), params_(params) {
+  if (!s.CheckSolutionValid()) {
+    std::cout << "The input solution is invalid. Exiting." << '\n';
+    exit(0);
+  }
+}
+
+void TabuSearchSolution::Solve() {
+  switch (cost_type_) {
+    case CostType::FLOAT:
+      Search<float>();
+      break;
+    case CostType::ROUNDED:
+      Search<int32_t>();
+      break;
+    default:
+      Search<double>();
+      break;
+  }
+  if (!verbose_) {
+    return;
+  }
+  for (const auto& i : nodes_) {
+    if (!i.is_routed_) {
+      std::cout << "Unreached node: " << '\n';
+      std::cout << OriginalNode(i) << '\n';
+    }
+  }
+  std::cout << "\n";
+  PrintSolution("route");
+}
+
+bool TabuSearchSolution::Step(const double seconds) {
+  const double cost = TotalCost();
+  const auto params = params_;
+  const bool verbose = verbose_;
+  params_.iteration_budget_ = 0;
+  params_.time_budget_ = seconds;
+  verbose_ = false;
+  Solve();
+  params_ = params;
+  verbose_ = verbose;
+  if (TotalCost() < cost) {
+    ReportIncumbent();
+  }
+  return true;
+}
+
+template <typename Cost>
+void TabuSearchSolution::Search() {
+  const CostMatrix<Cost> costs(*distanceMatrix_);
+  const auto& neighbors = *neighbors_;
+  RouteSet<Cost> routes(vehicles_, nodes_, costs);
+  const long long n_routes = routes.Size();
+
+  std::vector<int> customers;
+  for (size_t u = 0; u < nodes_.size(); u++) {
+    if (routes.RouteOf(u) >= 0) {
+      customers.push_back(u);
+    }
+  }
+  if (customers.empty() || params_.n_candidates_ <= 0) {
+    return;
+  }
+
+  std::default_random_engine rng(rand());
+  std::uniform_int_distribution<size_t> pick_node(0, customers.size() - 1);
+  const int min_tenure = std::max(1, params_.min_tenure_);
+  std::uniform_int_distribution<int> pick_tenure(
+      min_tenure, std::max(min_tenure, params_.max_tenure_));
+
+  // A move adds at most two attributes, each live for at most max tenure
+  // iterations
+  TabuMemory memory(2 * static_cast<size_t>(pick_tenure.max() + 1));
+  long long iteration = 0;
+
+  // Calls f(node, from, to) for the nodes whose route or position in a route
+  // is changed by the move, at most two per move
+  const auto for_attributes = [&](const TabuMove<Cost>& m, const auto& f) {
+    if (m.type_ == MoveType::RELOCATE) {
+      f(m.node_, m.r1_, m.r2_);
+    } else if (m.r1_ == m.r2_) {
+      f(routes[m.r1_][m.i1_], m.r1_, m.r1_);
+      f(routes[m.r1_][m.j1_], m.r1_, m.r1_);
+    } else {
+      if (m.i1_ != m.j1_) {
+        f(routes[m.r1_][m.i1_ + 1], m.r1_, m.r2_);
+      }
+      if (m.i2_ != m.j2_) {
+        f(routes[m.r2_][m.i2_ + 1], m.r2_, m.r1_);
+      }
+    }
+  };
+  const auto is_tabu = [&](const TabuMove<Cost>& m) {
+    bool tabu = false;
+    for_attributes(m, [&](const int node, const int, const int to) {
+      tabu = tabu || memory.IsTabu(node * n_routes + to, iteration);
+    });
+    return tabu;
+  };
+  const auto make_tabu = [&](const TabuMove<Cost>& m) {
+    for_attributes(m, [&](const int node, const int from, const int) {
+      memory.Add(node * n_routes + from, iteration,
+                 iteration + pick_tenure(rng));
+    });
+  };
+
+  Cost current = 0;
+  for (int k = 0; k < routes.Size(); k++) {
+    current += routes[k].Distance();
+  }
+  Cost best = current;
+  TabuMove<Cost> chosen;
+
+  // Keeps the move if it is the best so far that is either not tabu or leads
+  // to a new best solution
+  const auto consider = [&](const TabuMove<Cost>& m) {
+    if (m.delta_ < chosen.delta_ &&
+        (current + m.delta_ < best || !is_tabu(m))) {
+      chosen = m;
+    }
+  };
+
+  const auto relocate = [&](TabuMove<Cost> m, const int after) {
+    const auto& a = routes[m.r1_];
+    const auto& b = routes[m.r2_];
+    const int u = m.node_;
+    const int p = routes.PositionOf(u);
+    if (after < 0 || after > b.Size() - 2 ||
+        (m.r1_ == m.r2_ && (after == p || after == p - 1)) ||
+        (m.r1_ != m.r2_ && b.Load() + nodes_[u].demand_ > capacity_)) {
+      return;
+    }
+    m.type_ = MoveType::RELOCATE;
+    m.i2_ = after;
+    m.delta_ = costs(a[p - 1], a[p + 1]) - costs(a[p - 1], u) -
+               costs(u, a[p + 1]) + costs(b[after], u) +
+               costs(u, b[after + 1]) - costs(b[after], b[after + 1]);
+    consider(m);
+  };
+
+  const auto exchange = [&](TabuMove<Cost> m, const MoveType type,
+                            const int i1, const int j1, const int i2,
+                            const int j2) {
+    const auto& a = routes[m.r1_];
+    const auto& b = routes[m.r2_];
+    if (i1 < 0 || i2 < 0 || j1 > a.Size() - 2 || j2 > b.Size() - 2 ||
+        (i1 == j1 && i2 == j2)) {
+      return;
+    }
+    const int load_1 = a.Load(i1, j1);
+    const int load_2 = b.Load(i2, j2);
+    if (a.Load() - load_1 + load_2 > capacity_ ||
+        b.Load() - load_2 + load_1 > capacity_) {
+      return;
+    }
+    m = {type, m.node_, m.r1_, i1, j1, m.r2_, i2, j2,
+         routes.ExchangeDelta(m.r1_, i1, j1, m.r2_, i2, j2)};
+    consider(m);
+  };
+
+  const auto reverse = [&](TabuMove<Cost> m, const int i, const int j) {
+    const auto& a = routes[m.r1_];
+    if (i >= j) {
+      return;
+    }
+    m.type_ = MoveType::TWO_OPT;
+    m.i1_ = i;
+    m.j1_ = j;
+    m.delta_ = costs(a[i - 1], a[j]) + costs(a[i], a[j + 1]) -
+               costs(a[i - 1], a[i]) - costs(a[j], a[j + 1]);
+    consider(m);
+  };
+
+  // Moves that place the node next to the neighbor
+  const auto evaluate = [&](const int u, const int w) {
+    TabuMove<Cost> m;
+    m.node_ = u;
+    m.r1_ = routes.RouteOf(u);
+    m.r2_ = routes.RouteOf(w);
+    if (m.r2_ < 0) {
+      return;
+    }
+    const int p = routes.PositionOf(u);
+    const int q = routes.PositionOf(w);
+    relocate(m, q - 1);
+    relocate(m, q);
+    if (m.r1_ == m.r2_) {
+      reverse(m, std::min(p, q) + 1, std::max(p, q));
+      return;
+    }
+    exchange(m, MoveType::SWAP, p - 1, p, q, q + 1);
+    exchange(m, MoveType::SWAP, p - 1, p, q - 2, q - 1);
+    const int end_1 = routes[m.r1_].Size() - 2;
+    const int end_2 = routes[m.r2_].Size() - 2;
+    exchange(m, MoveType::TWO_OPT, p - 1, end_1, q, end_2);
+    exchange(m, MoveType::TWO_OPT, p, end_1, q - 1, end_2);
+  };
+
+  long long iteration_budget = params_.iteration_budget_;
+  if (iteration_budget <= 0 && params_.time_budget_ <= 0) {
+    iteration_budget = TabuParameters().iteration_budget_;
+  }
+
+  // The best routes are only copied when the search is about to move away
+  // from them
+  RouteSet<Cost> best_routes = routes;
+  bool best_saved = true;
+
+  const auto start = std::chrono::steady_clock::now();
+  for (; iteration_budget <= 0 || iteration < iteration_budget; iteration++) {
+    if (params_.time_budget_ > 0 && iteration % check_interval == 0) {
+      const std::chrono::duration<double> elapsed =
+          std::chrono::steady_clock::now() - start;
+      if (elapsed.count() >= params_.time_budget_) {
+        break;
+      }
+    }
+    chosen = TabuMove<Cost>();
+    for (int c = 0; c < params_.n_candidates_; c++) {
+      const int u = customers[pick_node(rng)];
+      for (const int w : neighbors.Of(u)) {
+        evaluate(u, w);
+      }
+    }
+    if (chosen.node_ < 0) {
+      continue;
+    }
+    if (chosen.delta_ > 0 && !best_saved) {
+      best_routes = routes;
+      best_saved = true;
+    }
+    make_tabu(chosen);
+    if (chosen.type_ == MoveType::RELOCATE) {
+      routes.Relocate(chosen.node_, chosen.r2_, chosen.i2_);
+    } else if (chosen.r1_ == chosen.r2_) {
+      routes.Reverse(chosen.r1_, chosen.i1_, chosen.j1_);
+    } else {
+      routes.Exchange(chosen.r1_, chosen.i1_, chosen.j1_, chosen.r2_,
+                      chosen.i2_, chosen.j2_);
+    }
+    current += chosen.delta_;
+    if (current < best) {
+      best = current;
+      best_saved = false;
+    }
+  }
+  if (best_saved) {
+    routes = best_routes;
+  }
+  routes.WriteBack(vehicles_, *distanceMatrix_, capacity_);
+}
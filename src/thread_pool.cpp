@@ -0,0 +1,90 @@
+/**
+ * @file thread_pool.cpp
+ * @author vss2sn
+ * @brief Contains the ThreadPool class used to run independent tasks of the
+ * solvers concurrently
+ */
+
+#include "cvrp/thread_pool.hpp"
+
+#include <algorithm>
+
+namespace {
+
+// Set for the worker threads so that nested loops run serially
+thread_local bool is_worker = false;
+
+}  // namespace
+
+ThreadPool::ThreadPool(const size_t n_threads) {
+  for (size_t i = 1; i < n_threads; i++) {
+    workers_.emplace_back([this]() { Work(); });
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  start_cv_.notify_all();
+  for (auto &worker : workers_) {
+    worker.join();
+  }
+}
+
+void ThreadPool::ParallelFor(const int n, const std::function<void(int)> &f) {
+  if (n <= 0) {
+    return;
+  }
+  std::unique_lock<std::mutex> run_lock(run_mutex_, std::try_to_lock);
+  if (!run_lock.owns_lock() || workers_.empty() || is_worker || n == 1) {
+    for (int i = 0; i < n; i++) {
+      f(i);
+    }
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    job_ = &f;
+    n_ = n;
+    next_ = 0;
+    active_ = workers_.size();
+    generation_++;
+  }
+  start_cv_.notify_all();
+  RunTasks();
+  std::unique_lock<std::mutex> lock(mutex_);
+  done_cv_.wait(lock, [this]() { return active_ == 0; });
+  job_ = nullptr;
+}
+
+void ThreadPool::Work() {
+  is_worker = true;
+  size_t seen = 0;
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    start_cv_.wait(lock, [this, &seen]() { return stop_ || generation_ != seen; });
+    if (stop_) {
+      return;
+    }
+    seen = generation_;
+    lock.unlock();
+    RunTasks();
+    lock.lock();
+    if (--active_ == 0) {
+      done_cv_.notify_one();
+    }
+  }
+}
+
+void ThreadPool::RunTasks() {
+  for (int i = next_++; i < n_; i = next_++) {
+    (*job_)(i);
+  }
+}
+
+ThreadPool &DefaultThreadPool() {
+  static ThreadPool pool(std::max(1U, std::thread::hardware_concurrency()));
+  return pool;
+}
@@ -15,6 +15,40 @@
 #include <utility>
 #include <fstream>
 
+#include "cvrp/kd_tree.hpp"
+#include "cvrp/neighbor_lists.hpp"
+
+namespace {
+
+constexpr int hilbert_order = 16;
+
+/**
+ * @brief Position of a point along a Hilbert curve
+ * @param x x coordinate on a grid of side 2^hilbert_order
+ * @param y y coordinate on a grid of side 2^hilbert_order
+ * @return uint64_t distance along the curve
+ */
+uint64_t HilbertIndex(uint32_t x, uint32_t y) {
+  constexpr uint32_t side = 1U << hilbert_order;
+  uint64_t d = 0;
+  for (uint32_t s = side / 2; s > 0; s /= 2) {
+    const uint32_t rx = (x & s) > 0 ? 1 : 0;
+    const uint32_t ry = (y & s) > 0 ? 1 : 0;
+    d += uint64_t(s) * s * ((3 * rx) ^ ry);
+    // Rotate the quadrant so that the curve is continuous
+    if (ry == 0) {
+      if (rx == 1) {
+        x = side - 1 - x;
+        y = side - 1 - y;
+      }
+      std::swap(x, y);
+    }
+  }
+  return d;
+}
+
+}  // namespace
+
 std::ostream &operator<<(std::ostream &os, const Node &node) {
   os << "Node Status" << '\n';
   os << "ID    : " << node.id_ << '\n';
@@ -65,7 +99,9 @@ Solution::Solution(std::vector<Node> nodes,
                    std::vector<std::vector<double>> distanceMatrix)
     : nodes_(std::move(nodes)),
       vehicles_(vehicles),
-      distanceMatrix_(std::move(distanceMatrix)) {
+      distanceMatrix_(std::make_shared<const std::vector<std::vector<double>>>(
+          std::move(distanceMatrix))),
+      neighbors_(std::make_shared<const NeighborLists>(nodes_)) {
   depot_ = nodes_[0];
   capacity_ = vehicles[0].load_;
 }
@@ -74,21 +110,26 @@ Solution::Solution(const Problem &p)
     : nodes_(p.nodes_),
       vehicles_(p.vehicles_),
       distanceMatrix_(p.distanceMatrix_),
-      capacity_(p.capacity_) {
+      neighbors_(p.neighbors_),
+      capacity_(p.capacity_),
+      cost_type_(p.cost_type_),
+      original_ids_(p.original_ids_) {
   depot_ = nodes_[0];
 }
 
 void Solution::CreateInitialSolution() {
+  auto unrouted = UnroutedIndex();
   for (auto &v : vehicles_) {
     while (true) {
-      const auto [found, closest_node] = find_closest(v);
+      const auto [found, closest_node] = find_closest(v, unrouted);
       if (found && v.load_ - closest_node.demand_ >= 0) {  // }.2*capacity){
         v.load_ -= closest_node.demand_;
-        v.cost_ += distanceMatrix_[v.nodes_.back()][closest_node.id_];
+        v.cost_ += (*distanceMatrix_)[v.nodes_.back()][closest_node.id_];
         v.nodes_.push_back(closest_node.id_);
         nodes_[closest_node.id_].is_routed_ = true;
+        unrouted.Erase(closest_node.id_);
       } else {
-        v.cost_ += distanceMatrix_[v.nodes_.back()][depot_.id_];
+        v.cost_ += (*distanceMatrix_)[v.nodes_.back()][depot_.id_];
         v.nodes_.push_back(depot_.id_);
         break;
       }
@@ -100,10 +141,10 @@ std::tuple<bool, Node> Solution::find_closest(const Vehicle &v) const {
   double cost = std::numeric_limits<double>::max();
   size_t id = 0;
   bool found = false;
-  for (size_t j = 0; j < distanceMatrix_[0].size(); j++) {
+  for (size_t j = 0; j < (*distanceMatrix_)[0].size(); j++) {
     if (!nodes_[j].is_routed_ && nodes_[j].demand_ <= v.load_ &&
-        distanceMatrix_[v.nodes_.back()][j] < cost) {
-      cost = distanceMatrix_[v.nodes_.back()][j];
+        (*distanceMatrix_)[v.nodes_.back()][j] < cost) {
+      cost = (*distanceMatrix_)[v.nodes_.back()][j];
       id = j;
       found = true;
     }
@@ -114,6 +155,26 @@ std::tuple<bool, Node> Solution::find_closest(const Vehicle &v) const {
   return {false, Node()};
 }
 
+std::tuple<bool, Node> Solution::find_closest(const Vehicle &v,
+                                              const KdTree &unrouted) const {
+  const Node &last = nodes_[v.nodes_.back()];
+  const auto [found, id] = unrouted.NearestFeasible(last.x_, last.y_, v.load_);
+  if (found) {
+    return {true, nodes_[id]};
+  }
+  return {false, Node()};
+}
+
+KdTree Solution::UnroutedIndex() const {
+  std::vector<int> ids;
+  for (const auto &n : nodes_) {
+    if (!n.is_routed_) {
+      ids.push_back(n.id_);
+    }
+  }
+  return KdTree(nodes_, std::move(ids));
+}
+
 bool Solution::CheckSolutionValid() const {
   // double cost = 0;
   std::vector<bool> check_nodes(nodes_.size(), false);
@@ -132,11 +193,29 @@ bool Solution::CheckSolutionValid() const {
                      [](const bool b) { return b; });
 }
 
+bool Solution::Step(const double /* seconds */) {
+  Solve();
+  ReportIncumbent();
+  return false;
+}
+
+double Solution::TotalCost() const {
+  double cost = 0;
+  for (const auto &v : vehicles_) {
+    for (size_t i = 1; i < v.nodes_.size(); ++i) {
+      cost += (*distanceMatrix_)[v.nodes_[i - 1]][v.nodes_[i]];
+    }
+  }
+  return cost;
+}
+
 
 Problem::Problem(std::vector<float> xc,
                  std::vector<float> yc, std::vector<float> demandc,
-                 const int noc, const int nov, const int capacity, std::string distribution) {
+                 const int noc, const int nov, const int capacity, std::string distribution,
+                 const CostType cost_type) {
   this->capacity_ = capacity;
+  this->cost_type_ = cost_type;
 
   if (distribution != "uniform" && distribution != "cluster") {
     distribution = "uniform";
@@ -150,17 +229,25 @@ Problem::Problem(std::vector<float> xc,
     }
   }
   
+  std::vector<std::vector<double>> distanceMatrix;
   std::vector<double> tmp(nodes_.size());
   for (size_t i = 0; i < nodes_.size(); ++i) {
-    distanceMatrix_.push_back(tmp);
+    distanceMatrix.push_back(tmp);
   }
   for (size_t i = 0; i < nodes_.size(); ++i) {
     for (size_t j = i; j < nodes_.size(); ++j) {
-      distanceMatrix_[i][j] = sqrt(pow((nodes_[i].x_ - nodes_[j].x_), 2) +
-                                   pow((nodes_[i].y_ - nodes_[j].y_), 2));
-      distanceMatrix_[j][i] = distanceMatrix_[i][j];
+      distanceMatrix[i][j] = sqrt(pow((nodes_[i].x_ - nodes_[j].x_), 2) +
+                                  pow((nodes_[i].y_ - nodes_[j].y_), 2));
+      if (cost_type_ == CostType::ROUNDED) {
+        distanceMatrix[i][j] = ToCost<int32_t>(distanceMatrix[i][j]);
+      }
+      distanceMatrix[j][i] = distanceMatrix[i][j];
     }
   }
+  distanceMatrix_ = std::make_shared<const std::vector<std::vector<double>>>(
+      std::move(distanceMatrix));
+
+  neighbors_ = std::make_shared<const NeighborLists>(nodes_);
 
   int load = capacity_;
   for (int i = 0; i < nov; ++i) {
@@ -183,6 +270,59 @@ Problem::Problem(std::vector<float> xc,
   //std::cout << std::endl << nodes_.size();
 }
 
+void Problem::RenumberCustomers() {
+  if (nodes_.size() < 3) {
+    return;
+  }
+  float min_x = nodes_[0].x_;
+  float max_x = nodes_[0].x_;
+  float min_y = nodes_[0].y_;
+  float max_y = nodes_[0].y_;
+  for (const auto &n : nodes_) {
+    min_x = std::min(min_x, n.x_);
+    max_x = std::max(max_x, n.x_);
+    min_y = std::min(min_y, n.y_);
+    max_y = std::max(max_y, n.y_);
+  }
+  // Scale the locations onto the grid of the curve, keeping the aspect ratio
+  constexpr float grid = (1U << hilbert_order) - 1;
+  const float range = std::max({max_x - min_x, max_y - min_y, 1.0F});
+  std::vector<std::pair<uint64_t, int>> keys;
+  keys.reserve(nodes_.size() - 1);
+  for (size_t i = 1; i < nodes_.size(); ++i) {
+    const auto x = static_cast<uint32_t>((nodes_[i].x_ - min_x) / range * grid);
+    const auto y = static_cast<uint32_t>((nodes_[i].y_ - min_y) / range * grid);
+    keys.emplace_back(HilbertIndex(x, y), i);
+  }
+  std::sort(keys.begin(), keys.end());
+
+  // order[new id] = current id
+  std::vector<int> order{0};
+  for (const auto &key : keys) {
+    order.push_back(key.second);
+  }
+  std::vector<Node> nodes;
+  nodes.reserve(nodes_.size());
+  std::vector<std::vector<double>> distanceMatrix(nodes_.size());
+  for (size_t i = 0; i < nodes_.size(); ++i) {
+    nodes.push_back(nodes_[order[i]]);
+    nodes.back().id_ = i;
+    distanceMatrix[i].resize(nodes_.size());
+    for (size_t j = 0; j < nodes_.size(); ++j) {
+      distanceMatrix[i][j] = (*distanceMatrix_)[order[i]][order[j]];
+    }
+  }
+  auto original_ids = std::make_shared<std::vector<int>>(nodes_.size());
+  for (size_t i = 0; i < nodes_.size(); ++i) {
+    (*original_ids)[i] = original_ids_ ? (*original_ids_)[order[i]] : order[i];
+  }
+  nodes_ = std::move(nodes);
+  distanceMatrix_ = std::make_shared<const std::vector<std::vector<double>>>(
+      std::move(distanceMatrix));
+  original_ids_ = std::move(original_ids);
+  neighbors_ = std::make_shared<const NeighborLists>(nodes_);
+}
+
 void Solution::PrintSolution(const std::string &option, std::string dir, const int gen) const {
   std::ofstream myfileoutput;
   std::ofstream myfilesolutions;
@@ -216,7 +356,7 @@ void Solution::PrintSolution(const std::string &option, std::string dir, const i
     double max_depth = 0;
     double vari = 0;
     if (option == "status") {
-      PrintVehicleRoute(v);
+      PrintVehicleRoute(OriginalRoute(v));
     } else if (option == "route") {
         if (v.nodes_.size() != 1) {
           vehicles +=1;
@@ -224,17 +364,17 @@ void Solution::PrintSolution(const std::string &option, std::string dir, const i
           myfilesolutions << "v" <<v.id_ << ":";
           myfilesolutions << "(";
           for (size_t i = 0; i < v.nodes_.size() - 1; ++i) {
-            std::cout << v.nodes_[i] << "->";
-            //std::cout << distanceMatrix_[v.nodes_[i]][v.nodes_[i+1]]<< " ";
-            myfilesolutions << v.nodes_[i] << ",";
-            mean += distanceMatrix_[v.nodes_[i]][v.nodes_[i+1]];
-            avg_cust_depot += distanceMatrix_[0][v.nodes_[i]];
+            std::cout << OriginalId(v.nodes_[i]) << "->";
+            //std::cout << (*distanceMatrix_)[v.nodes_[i]][v.nodes_[i+1]]<< " ";
+            myfilesolutions << OriginalId(v.nodes_[i]) << ",";
+            mean += (*distanceMatrix_)[v.nodes_[i]][v.nodes_[i+1]];
+            avg_cust_depot += (*distanceMatrix_)[0][v.nodes_[i]];
             vari += (i - v.nodes_.size())*(i - v.nodes_.size());
-            if (distanceMatrix_[v.nodes_[i]][v.nodes_[i+1]] > max_dist){
-              max_dist = distanceMatrix_[v.nodes_[i]][v.nodes_[i+1]];
+            if ((*distanceMatrix_)[v.nodes_[i]][v.nodes_[i+1]] > max_dist){
+              max_dist = (*distanceMatrix_)[v.nodes_[i]][v.nodes_[i+1]];
             }
-            if (distanceMatrix_[0][v.nodes_[i]] > max_depth){
-              max_depth = distanceMatrix_[0][v.nodes_[i]];
+            if ((*distanceMatrix_)[0][v.nodes_[i]] > max_depth){
+              max_depth = (*distanceMatrix_)[0][v.nodes_[i]];
             }
             
           }
@@ -268,7 +408,7 @@ void Solution::PrintSolution(const std::string &option, std::string dir, const i
     for (const auto &i : nodes_) {
       if (!i.is_routed_) {
         std::cout << "Unreached node: " << '\n';
-        std::cout << i << '\n';
+        std::cout << OriginalNode(i) << '\n';
       }
     }
   } 